@@ -0,0 +1,158 @@
+/**
+ * SuperPy Engine Benchmark Suite
+ *
+ * Native throughput of the engine without Python in the way: frames per
+ * second with and without rendering, screen conversion, save/load state,
+ * reset and batched stepping, each with and without video where that
+ * applies (no-video engines, see SuperPyEngine). Without a ROM argument it
+ * runs the generated homebrew test ROM (see test_rom.h), so it works in CI;
+ * numbers on a real game are more representative and the two should not be
+ * compared.
+ *
+ * Usage: superpy_bench [rom] [seconds per case] [envs]
+ * (run next to the superpy_snes9x core library, i.e. in the build directory)
+ */
+
+#include "snes9x_adapter.h"
+#include "test_rom.h"
+#include "vector_engine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace superpy;
+
+// Run fn(batch) in growing batches until `seconds` have passed; returns
+// units per second, where fn returns the units it did
+template <typename Fn>
+static double measure(double seconds, Fn&& fn) {
+    using clock = std::chrono::steady_clock;
+    fn(1);  // warm-up
+
+    double units = 0;
+    int batch = 1;
+    auto start = clock::now();
+    std::chrono::duration<double> elapsed(0);
+    while (elapsed.count() < seconds) {
+        units += fn(batch);
+        elapsed = clock::now() - start;
+        if (batch < (1 << 16)) batch *= 2;
+    }
+    return units / elapsed.count();
+}
+
+static void report(const char* name, double rate, const char* unit) {
+    std::printf("%-36s %12.0f %s\n", name, rate, unit);
+}
+
+int main(int argc, char** argv) {
+    std::string rom = argc > 1 ? argv[1] : "";
+    double seconds = argc > 2 ? std::atof(argv[2]) : 1.0;
+    int envs = argc > 3 ? std::atoi(argv[3]) : 8;
+
+    bool generated = rom.empty() || rom == "-";
+    if (generated) {
+        rom = "superpy_bench_" + std::to_string(getpid()) + ".sfc";
+        if (!bench::write_test_rom(rom)) {
+            std::fprintf(stderr, "failed to write test ROM: %s\n", rom.c_str());
+            return 1;
+        }
+        std::printf("ROM: generated test ROM\n");
+    } else {
+        std::printf("ROM: %s\n", rom.c_str());
+    }
+
+    SuperPyEngine engine;
+    SuperPyEngine blind(false);
+    VectorEngine vec(envs);
+    VectorEngine blind_vec(envs, 0, false);
+    bool loaded = engine.load_rom(rom) && blind.load_rom(rom) && vec.load_rom(rom) && blind_vec.load_rom(rom);
+    if (generated) std::remove(rom.c_str());
+    if (!loaded) {
+        std::fprintf(stderr, "failed to load ROM\n");
+        return 1;
+    }
+
+    // Get past the boot frames so the state is representative
+    engine.tick(300, false, 0);
+    engine.add_reset_state();
+    blind.tick(300, false, 0);
+
+    report("tick (render)", measure(seconds, [&](int n) {
+        engine.tick(n, true, 0);
+        return n;
+    }), "frames/s");
+
+    report("tick (no render)", measure(seconds, [&](int n) {
+        engine.tick(n, false, 0);
+        return n;
+    }), "frames/s");
+
+    report("step + get_screen", measure(seconds, [&](int n) {
+        for (int i = 0; i < n; i++) {
+            engine.step(0);
+            engine.get_screen();
+        }
+        return n;
+    }), "frames/s");
+
+    report("step (no video)", measure(seconds, [&](int n) {
+        for (int i = 0; i < n; i++) blind.step(0);
+        return n;
+    }), "frames/s");
+
+    report("tick (no video)", measure(seconds, [&](int n) {
+        blind.tick(n, false, 0);
+        return n;
+    }), "frames/s");
+
+    report("get_screen", measure(seconds, [&](int n) {
+        for (int i = 0; i < n; i++) engine.get_screen();
+        return n;
+    }), "calls/s");
+
+    std::vector<uint8_t> state(engine.state_size());
+    report("save_state_into", measure(seconds, [&](int n) {
+        for (int i = 0; i < n; i++) engine.save_state_into(state.data(), state.size());
+        return n;
+    }), "states/s");
+
+    report("load_state", measure(seconds, [&](int n) {
+        for (int i = 0; i < n; i++) engine.load_state(state.data(), state.size());
+        return n;
+    }), "states/s");
+
+    report("reset (start state)", measure(seconds, [&](int n) {
+        for (int i = 0; i < n; i++) engine.reset();
+        return n;
+    }), "resets/s");
+
+    engine.clear_reset_states();
+    report("reset (power cycle)", measure(seconds, [&](int n) {
+        for (int i = 0; i < n; i++) engine.reset();
+        return n;
+    }), "resets/s");
+
+    // Batched: 4 frames per step into 84x84 gray observations
+    ObservationSpec spec;
+    spec.width = 84;
+    spec.height = 84;
+    spec.color = ObsColor::Gray;
+    std::vector<uint32_t> actions(envs, 0);
+    for (VectorEngine* batch : {&vec, &blind_vec}) {
+        batch->set_observation(spec);
+        char name[64];
+        std::snprintf(name, sizeof(name), "VectorEngine x%d (%d thr%s)", envs, batch->num_threads(),
+                      batch == &blind_vec ? ", no video" : "");
+        report(name, measure(seconds, [&](int n) {
+            for (int i = 0; i < n; i++) batch->step(actions.data(), 4);
+            return 4 * n * envs;
+        }), "frames/s");
+    }
+    return 0;
+}
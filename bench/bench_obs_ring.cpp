@@ -0,0 +1,202 @@
+/**
+ * SuperPy Observation Ring Benchmark
+ *
+ * Steps per second of N worker processes sending their observations,
+ * rewards and dones to the parent through an ObservationRing, next to the
+ * same workers writing them into pipes (the transport of a pipe-based
+ * vector env, minus the pickling). frames = 0 skips emulation and measures
+ * the transport alone.
+ *
+ * Usage: superpy_bench_obs_ring <rom> [envs] [steps] [frames]
+ * (run next to the superpy_snes9x core library, i.e. in the build directory)
+ */
+
+#include "obs_ring.h"
+#include "snes9x_adapter.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace superpy;
+
+struct Result {
+    float reward;
+    bool done;
+};
+
+static void emulate(SuperPyEngine& engine, int frames) {
+    if (frames <= 0) return;
+    if (frames > 1) engine.tick(frames - 1, false, 0);
+    engine.step(0);
+}
+
+static bool write_all(int fd, const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool read_all(int fd, void* data, size_t size) {
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool reap(const std::vector<pid_t>& pids) {
+    bool ok = true;
+    for (pid_t pid : pids) {
+        int status;
+        waitpid(pid, &status, 0);
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    return ok;
+}
+
+// Error paths: stop and reap the workers started so far (pid 0 = none)
+static double abort_workers(const std::vector<pid_t>& pids, const std::vector<int>& fds = {}) {
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+    for (pid_t pid : pids) {
+        if (pid > 0) kill(pid, SIGKILL);
+    }
+    for (pid_t pid : pids) {
+        if (pid > 0) waitpid(pid, nullptr, 0);
+    }
+    return 0;
+}
+
+static double run_pipes(SuperPyEngine& engine, int envs, int steps, int frames) {
+    size_t obs_size = engine.observation_size();
+    std::vector<int> fds(envs, -1);
+    std::vector<pid_t> pids(envs, 0);
+
+    for (int i = 0; i < envs; i++) {
+        int pipe_fds[2];
+        if (pipe(pipe_fds) != 0) return abort_workers(pids, fds);
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(pipe_fds[0]);
+            close(pipe_fds[1]);
+            return abort_workers(pids, fds);
+        }
+        if (pid == 0) {
+            close(pipe_fds[0]);
+            std::vector<uint8_t> message(obs_size + sizeof(Result));
+            for (int step = 0; step < steps; step++) {
+                emulate(engine, frames);
+                engine.observe(message.data());
+                Result result = {1.0f, engine.is_done()};
+                std::memcpy(message.data() + obs_size, &result, sizeof(result));
+                if (!write_all(pipe_fds[1], message.data(), message.size())) _exit(1);
+            }
+            _exit(0);
+        }
+        close(pipe_fds[1]);
+        fds[i] = pipe_fds[0];
+        pids[i] = pid;
+    }
+
+    std::vector<uint8_t> observations(envs * obs_size);
+    std::vector<Result> results(envs);
+    auto start = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; step++) {
+        for (int i = 0; i < envs; i++) {
+            if (!read_all(fds[i], observations.data() + i * obs_size, obs_size) ||
+                !read_all(fds[i], &results[i], sizeof(Result))) {
+                return abort_workers(pids, fds);
+            }
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    for (int fd : fds) close(fd);
+    return reap(pids) ? double(envs) * steps / elapsed.count() : 0;
+}
+
+static double run_ring(SuperPyEngine& engine, const ObservationSpec& spec, int envs, int steps, int frames) {
+    std::string name = "/superpy_bench_" + std::to_string(getpid());
+    ObservationRing ring(name, envs, 2, spec, {0x0000, 0x0001});
+    std::vector<pid_t> pids(envs, 0);
+
+    for (int i = 0; i < envs; i++) {
+        pid_t pid = fork();
+        if (pid < 0) return abort_workers(pids);
+        if (pid == 0) {
+            // Attach by name, as an independently started worker would
+            ObservationRing worker(name);
+            for (int step = 0; step < steps; step++) {
+                emulate(engine, frames);
+                if (!worker.push(i, engine, 1.0f, engine.is_done(), 10000)) _exit(1);
+            }
+            _exit(0);
+        }
+        pids[i] = pid;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; step++) {
+        if (!ring.wait(10000)) return abort_workers(pids);
+        ring.release();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return reap(pids) ? double(envs) * steps / elapsed.count() : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <rom> [envs] [steps] [frames]\n", argv[0]);
+        return 2;
+    }
+    int envs = argc > 2 ? std::atoi(argv[2]) : 8;
+    int steps = argc > 3 ? std::atoi(argv[3]) : 2000;
+    int frames = argc > 4 ? std::atoi(argv[4]) : 4;
+
+    SuperPyEngine engine;
+    if (!engine.load_rom(argv[1])) {
+        std::fprintf(stderr, "failed to load ROM: %s\n", argv[1]);
+        return 1;
+    }
+    engine.tick(300, false, 0);
+
+    std::printf("%d envs, %d steps, %d frames per step\n", envs, steps, frames);
+
+    // Full-frame RGB, as with screen.copy(), then a typical Atari-style spec
+    ObservationSpec full;
+    ObservationSpec small;
+    small.width = 84;
+    small.height = 84;
+    small.color = ObsColor::Gray;
+
+    for (const ObservationSpec* spec : {&full, &small}) {
+        engine.set_observation(*spec);
+        size_t shape[3];
+        engine.observation().shape(shape);
+
+        double pipes = run_pipes(engine, envs, steps, frames);
+        double ring = run_ring(engine, *spec, envs, steps, frames);
+        std::printf("%zux%zux%zu observations\n", shape[0], shape[1], shape[2]);
+        std::printf("  %-16s %12.0f steps/s\n", "pipes", pipes);
+        std::printf("  %-16s %12.0f steps/s  (%.2fx)\n", "ObservationRing", ring, pipes > 0 ? ring / pipes : 0.0);
+    }
+    return 0;
+}
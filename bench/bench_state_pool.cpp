@@ -0,0 +1,104 @@
+/**
+ * SuperPy State Pool Benchmark
+ *
+ * Measures saves and restores per second through StatePool slots, next to
+ * the allocating save_state()/load_state() path, on a real ROM, and the
+ * rate and compression of DeltaArchive trajectories.
+ *
+ * Usage: superpy_bench_state_pool <rom> [slots] [iterations]
+ * (run next to the superpy_snes9x core library, i.e. in the build directory)
+ */
+
+#include "delta_archive.h"
+#include "snes9x_adapter.h"
+#include "state_pool.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace superpy;
+
+template <typename Fn>
+static double ops_per_second(int iterations, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        fn(i);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return iterations / elapsed.count();
+}
+
+static void report(const char* name, double rate, size_t state_size) {
+    std::printf("%-24s %12.0f ops/s %10.1f MB/s\n", name, rate, rate * state_size / 1e6);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <rom> [slots] [iterations]\n", argv[0]);
+        return 2;
+    }
+    int slots = argc > 2 ? std::atoi(argv[2]) : 256;
+    int iterations = argc > 3 ? std::atoi(argv[3]) : 5000;
+
+    SuperPyEngine engine;
+    if (!engine.load_rom(argv[1])) {
+        std::fprintf(stderr, "failed to load ROM: %s\n", argv[1]);
+        return 1;
+    }
+    // Get past the boot frames so the state is representative
+    engine.tick(300, false, 0);
+
+    StatePool pool(engine, slots);
+    size_t size = pool.state_size();
+    std::printf("state size: %zu bytes, %d slots (%.1f MB)\n", size, slots, slots * size / 1e6);
+
+    double rate = ops_per_second(iterations, [&](int) {
+        engine.save_state();
+    });
+    report("save_state (vector)", rate, size);
+
+    std::vector<uint8_t> state = engine.save_state();
+    rate = ops_per_second(iterations, [&](int) {
+        engine.load_state(state);
+    });
+    report("load_state (vector)", rate, size);
+
+    rate = ops_per_second(iterations, [&](int i) {
+        pool.save(i % slots);
+    });
+    report("StatePool::save", rate, size);
+
+    rate = ops_per_second(iterations, [&](int i) {
+        pool.restore(i % slots);
+    });
+    report("StatePool::restore", rate, size);
+
+    // Typical search step: restore a node, expand it by one frame, save the child
+    rate = ops_per_second(iterations, [&](int i) {
+        pool.restore(i % slots);
+        engine.tick(1, false, 0);
+        pool.save((i + 1) % slots);
+    });
+    report("restore + frame + save", rate, size);
+
+    // Delta archive: one trajectory, each frame saved against the previous one
+    DeltaArchive archive(engine, 32);
+    int last = -1;
+    rate = ops_per_second(iterations, [&](int) {
+        engine.tick(1, false, 0);
+        last = archive.save(last);
+    });
+    report("DeltaArchive::save", rate, size);
+    std::printf("  %d snapshots in %.1f MB (%.1f KB each, %.0fx smaller)\n", archive.size(),
+                archive.memory_bytes() / 1e6, archive.memory_bytes() / 1e3 / archive.size(),
+                static_cast<double>(size) * archive.size() / archive.memory_bytes());
+
+    rate = ops_per_second(iterations, [&](int i) {
+        archive.restore((i * 7919) % archive.size());
+    });
+    report("DeltaArchive::restore", rate, size);
+
+    return 0;
+}
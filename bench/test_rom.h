@@ -0,0 +1,156 @@
+/**
+ * SuperPy Benchmark Test ROM
+ *
+ * A small homebrew LoROM program, generated at run time so the benchmarks
+ * need no game ROM (nothing copyrighted is bundled). It turns on a mode 1
+ * background whose tiles, tilemap and palette are DMAed from pseudo-random
+ * ROM bytes, scrolls it one pixel per frame from the NMI handler and spins
+ * on RAM counters in between, so every frame exercises the 65816 core,
+ * DMA and the full PPU rendering path.
+ *
+ * WRAM layout (for checks against the RAM):
+ *   $0000-$0001  main loop counter
+ *   $0002        frame counter (incremented by NMI)
+ *   $0003        joypad 1 low byte (auto-read, $4218)
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace superpy {
+namespace bench {
+
+inline std::vector<uint8_t> make_test_rom() {
+    std::vector<uint8_t> rom(0x8000, 0);
+
+    // Tile, tilemap and palette source data: $9000-$FEFF
+    uint32_t seed = 0x12345678;
+    for (size_t i = 0x1000; i < 0x7F00; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        rom[i] = static_cast<uint8_t>(seed >> 24);
+    }
+
+    // Reset handler at $8000
+    static const uint8_t reset[] = {
+        0x78,                   // sei
+        0x18, 0xFB,             // clc; xce           native mode
+        0xC2, 0x30,             // rep #$30
+        0xA2, 0xFF, 0x1F,       // ldx #$1FFF
+        0x9A,                   // txs
+        0xE2, 0x20,             // sep #$20           8-bit A
+        0xA9, 0x80,             // lda #$80
+        0x8D, 0x00, 0x21,       // sta $2100          forced blank
+        0x9C, 0x00, 0x42,       // stz $4200
+        0xA9, 0x01,             // lda #$01
+        0x8D, 0x05, 0x21,       // sta $2105          BG mode 1
+        0xA9, 0x04,             // lda #$04
+        0x8D, 0x07, 0x21,       // sta $2107          BG1 tilemap at VRAM $0400
+        0x9C, 0x0B, 0x21,       // stz $210B          BG1 tiles at VRAM $0000
+        // VRAM $0000-$07FF <- ROM $9000 (4KB) via DMA channel 0
+        0xA9, 0x80,             // lda #$80
+        0x8D, 0x15, 0x21,       // sta $2115
+        0x9C, 0x16, 0x21,       // stz $2116
+        0x9C, 0x17, 0x21,       // stz $2117
+        0xA9, 0x01,             // lda #$01
+        0x8D, 0x00, 0x43,       // sta $4300          two registers, once each
+        0xA9, 0x18,             // lda #$18
+        0x8D, 0x01, 0x43,       // sta $4301          -> $2118/$2119
+        0x9C, 0x02, 0x43,       // stz $4302
+        0xA9, 0x90,             // lda #$90
+        0x8D, 0x03, 0x43,       // sta $4303          source $00:9000
+        0x9C, 0x04, 0x43,       // stz $4304
+        0x9C, 0x05, 0x43,       // stz $4305
+        0xA9, 0x10,             // lda #$10
+        0x8D, 0x06, 0x43,       // sta $4306          $1000 bytes
+        0xA9, 0x01,             // lda #$01
+        0x8D, 0x0B, 0x42,       // sta $420B
+        // CGRAM <- ROM $A000 (512 bytes)
+        0x9C, 0x21, 0x21,       // stz $2121
+        0x9C, 0x00, 0x43,       // stz $4300          one register
+        0xA9, 0x22,             // lda #$22
+        0x8D, 0x01, 0x43,       // sta $4301          -> $2122
+        0x9C, 0x02, 0x43,       // stz $4302
+        0xA9, 0xA0,             // lda #$A0
+        0x8D, 0x03, 0x43,       // sta $4303          source $00:A000
+        0x9C, 0x05, 0x43,       // stz $4305
+        0xA9, 0x02,             // lda #$02
+        0x8D, 0x06, 0x43,       // sta $4306          $200 bytes
+        0xA9, 0x01,             // lda #$01
+        0x8D, 0x0B, 0x42,       // sta $420B
+        0xA9, 0x01,             // lda #$01
+        0x8D, 0x2C, 0x21,       // sta $212C          BG1 on the main screen
+        0xA9, 0x0F,             // lda #$0F
+        0x8D, 0x00, 0x21,       // sta $2100          screen on, full brightness
+        0xA9, 0x81,             // lda #$81
+        0x8D, 0x00, 0x42,       // sta $4200          NMI and joypad auto-read
+        // loop:
+        0xEE, 0x00, 0x00,       // inc $0000
+        0xD0, 0xFB,             // bne loop
+        0xEE, 0x01, 0x00,       // inc $0001
+        0x80, 0xF6,             // bra loop
+    };
+
+    // NMI handler at $8100
+    static const uint8_t nmi[] = {
+        0x48,                   // pha
+        0xAD, 0x10, 0x42,       // lda $4210          acknowledge
+        0xEE, 0x02, 0x00,       // inc $0002
+        0xAD, 0x02, 0x00,       // lda $0002
+        0x8D, 0x0D, 0x21,       // sta $210D          BG1 horizontal scroll
+        0x9C, 0x0D, 0x21,       // stz $210D
+        0x8D, 0x0E, 0x21,       // sta $210E          BG1 vertical scroll
+        0x9C, 0x0E, 0x21,       // stz $210E
+        0xAD, 0x18, 0x42,       // lda $4218
+        0x8D, 0x03, 0x00,       // sta $0003
+        0x68,                   // pla
+        0x40,                   // rti
+    };
+
+    std::copy(reset, reset + sizeof(reset), rom.begin());
+    std::copy(nmi, nmi + sizeof(nmi), rom.begin() + 0x100);
+    rom[0x180] = 0x40;          // rti, for every other vector
+
+    // Header at $FFC0
+    const char title[] = "SUPERPY BENCH        ";
+    std::copy(title, title + 21, rom.begin() + 0x7FC0);
+    rom[0x7FD5] = 0x20;         // LoROM, slow
+    rom[0x7FD6] = 0x00;         // ROM only
+    rom[0x7FD7] = 0x05;         // 32KB
+    rom[0x7FD9] = 0x01;         // North America
+    rom[0x7FDA] = 0x33;
+
+    auto vector = [&](size_t offset, uint16_t address) {
+        rom[offset] = static_cast<uint8_t>(address);
+        rom[offset + 1] = static_cast<uint8_t>(address >> 8);
+    };
+    for (size_t offset = 0x7FE4; offset < 0x8000; offset += 2) vector(offset, 0x8180);
+    vector(0x7FEA, 0x8100);     // native NMI
+    vector(0x7FFC, 0x8000);     // reset
+
+    // Checksum over the image with checksum + complement counted as $FF $FF
+    // $00 $00, which is what they sum to once filled in
+    rom[0x7FDC] = rom[0x7FDD] = 0xFF;
+    rom[0x7FDE] = rom[0x7FDF] = 0x00;
+    uint16_t sum = 0;
+    for (uint8_t byte : rom) sum = static_cast<uint16_t>(sum + byte);
+    vector(0x7FDC, static_cast<uint16_t>(~sum));
+    vector(0x7FDE, sum);
+    return rom;
+}
+
+// Write the test ROM to `path`; false on I/O errors
+inline bool write_test_rom(const std::string& path) {
+    std::vector<uint8_t> rom = make_test_rom();
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = std::fwrite(rom.data(), 1, rom.size(), file) == rom.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+} // namespace bench
+} // namespace superpy
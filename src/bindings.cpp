@@ -9,60 +9,636 @@
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/map.h>
 #include <nanobind/stl/vector.h>
+#include <nanobind/stl/optional.h>
+#include <nanobind/stl/tuple.h>
 
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
+
+#include "delta_archive.h"
+#include "fork_server.h"
+#include "obs_ring.h"
+#include "ram_features.h"
+#include "reward_program.h"
 #include "snes9x_adapter.h"
+#include "state_pool.h"
+#include "test_rom.h"
+#include "vector_engine.h"
 
 namespace nb = nanobind;
 
+using Actions = nb::ndarray<const uint32_t, nb::ndim<1>, nb::c_contig, nb::device::cpu>;
+using ActionIndices = nb::ndarray<const int64_t, nb::ndim<1>, nb::c_contig, nb::device::cpu>;
+using Buttons = nb::ndarray<const uint8_t, nb::ndim<1>, nb::c_contig, nb::device::cpu>;
+using StateBuffer = nb::ndarray<uint8_t, nb::c_contig, nb::device::cpu>;
+using ConstStateBuffer = nb::ndarray<const uint8_t, nb::c_contig, nb::device::cpu>;
+using Crop = std::optional<std::tuple<int, int, int, int>>;
+using Size = std::optional<std::tuple<int, int>>;
+
+// Release the GIL and run fn while holding the object's call mutex: long
+// emulation calls overlap with other Python threads, but two threads never
+// run inside the same engine at once
+template <typename T, typename Fn>
+static auto without_gil(T& self, Fn&& fn) {
+    nb::gil_scoped_release release;
+    std::lock_guard<std::mutex> lock(self.call_mutex());
+    return fn();
+}
+
+// Joypad input forms accepted by Engine.step/tick/step_skip: a button dict,
+// a raw joypad mask, or a MultiBinary(12) array in BUTTONS order
+static uint32_t input_mask(const std::map<std::string, bool>& input) {
+    return superpy::SuperPyEngine::buttons_to_mask(input);
+}
+
+static uint32_t input_mask(uint32_t input) {
+    return input;
+}
+
+static uint32_t input_mask(const Buttons& input) {
+    return superpy::SuperPyEngine::buttons_to_mask(input.data(), input.shape(0));
+}
+
+static bool pool_is_max(const std::string& pool) {
+    if (pool != "max" && pool != "last") {
+        throw std::invalid_argument("pool must be 'max' or 'last'");
+    }
+    return pool == "max";
+}
+
+static std::vector<uint32_t> action_table(const std::vector<uint32_t>& masks) {
+    if (masks.empty()) {
+        throw std::invalid_argument("action table must not be empty");
+    }
+    return masks;
+}
+
+// Python timeout in seconds (None = wait forever) to milliseconds
+static int timeout_ms(std::optional<double> seconds) {
+    if (!seconds) return -1;
+    return *seconds <= 0 ? 0 : static_cast<int>(*seconds * 1000.0);
+}
+
+static nb::dlpack::dtype obs_dtype(size_t element_size) {
+    return element_size == sizeof(uint16_t) ? nb::dtype<uint16_t>() : nb::dtype<uint8_t>();
+}
+
+// Build an ObservationSpec from the Python-facing keyword arguments
+static superpy::ObservationSpec make_spec(const Crop& crop, const Size& size,
+                                          const std::string& interpolation,
+                                          const std::string& color,
+                                          const std::string& layout, bool full_range) {
+    superpy::ObservationSpec spec;
+    if (crop) {
+        std::tie(spec.crop_x, spec.crop_y, spec.crop_width, spec.crop_height) = *crop;
+    }
+    if (size) {
+        std::tie(spec.height, spec.width) = *size;
+    }
+    spec.interpolation = superpy::ObservationSpec::parse_interpolation(interpolation);
+    spec.color = superpy::ObservationSpec::parse_color(color);
+    spec.layout = superpy::ObservationSpec::parse_layout(layout);
+    spec.full_range = full_range;
+    return spec;
+}
+
+// Run fill(dst) without the GIL, writing into the caller-owned array `out`
+// or, if out is None, into a freshly allocated observation array
+template <typename Fill>
+static nb::object observation_into(superpy::SuperPyEngine& self, nb::object out, Fill&& fill) {
+    size_t shape[3];
+    size_t size_bytes = 0;
+    size_t element_size = 0;
+    without_gil(self, [&] {
+        const superpy::ObservationPipeline& obs = self.observation();
+        obs.shape(shape);
+        size_bytes = obs.size_bytes();
+        element_size = obs.element_size();
+    });
+
+    nb::object result = out;
+    void* dst = nullptr;
+    if (out.is_none()) {
+        uint8_t* data = new uint8_t[size_bytes];
+        nb::capsule owner(data, [](void* p) noexcept { delete[] static_cast<uint8_t*>(p); });
+        result = nb::cast(nb::ndarray<nb::numpy>(data, 3, shape, owner, nullptr, obs_dtype(element_size)));
+        dst = data;
+    } else {
+        // Caller-owned buffer: written in place, no allocation
+        auto buffer = nb::cast<nb::ndarray<nb::c_contig, nb::device::cpu>>(out);
+        if (buffer.nbytes() != size_bytes || buffer.itemsize() != element_size) {
+            throw std::invalid_argument("out must be a C-contiguous array matching observation_shape and dtype");
+        }
+        dst = buffer.data();
+    }
+
+    bool written = without_gil(self, [&] {
+        // The spec may have been replaced by another thread meanwhile
+        if (self.observation_size() != size_bytes) return false;
+        fill(dst);
+        return true;
+    });
+    if (!written) {
+        throw std::runtime_error("observation spec changed during the call");
+    }
+    return result;
+}
+
+// RAM address string: "0x"/"$" prefixed hex or plain decimal. Leading zeros
+// in decimal are rejected rather than read as octal, as is trailing junk.
+static uint32_t parse_address(const std::string& text) {
+    size_t digits = 0;
+    int base = 10;
+    if (text.size() >= 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        digits = 2;
+        base = 16;
+    } else if (text.size() > 1 && text[0] == '$') {
+        digits = 1;
+        base = 16;
+    } else if (text.size() > 1 && text[0] == '0') {
+        throw std::invalid_argument("invalid RAM address '" + text +
+                                    "': leading zeros are ambiguous, use '0x...' for hex or plain decimal");
+    }
+
+    uint32_t address = 0;
+    const char* begin = text.data() + digits;
+    const char* end = text.data() + text.size();
+    auto [ptr, error] = std::from_chars(begin, end, address, base);
+    if (begin == end || error != std::errc() || ptr != end) {
+        throw std::invalid_argument("invalid RAM address '" + text + "' (expected '0x...', '$...' or decimal)");
+    }
+    return address;
+}
+
+// One RAM feature from a Python dict: address (int or "0x..."/"$..." string),
+// type, endian, bcd, mask, shift and scale. name/description and the
+// caller's own keys are skipped, so RAM map JSON entries work as they are.
+static superpy::RamFeature make_feature(nb::handle item, std::initializer_list<const char*> skip = {}) {
+    superpy::RamFeature feature;
+    bool has_address = false;
+    for (auto [key, value] : nb::cast<nb::dict>(item)) {
+        std::string name = nb::cast<std::string>(key);
+        if (name == "address") {
+            if (nb::isinstance<nb::str>(value)) {
+                feature.address = parse_address(nb::cast<std::string>(value));
+            } else {
+                feature.address = nb::cast<uint32_t>(value);
+            }
+            has_address = true;
+        } else if (name == "type") {
+            feature.type = superpy::RamFeature::parse_type(nb::cast<std::string>(value));
+        } else if (name == "endian") {
+            std::string endian = nb::cast<std::string>(value);
+            if (endian != "little" && endian != "big") {
+                throw std::invalid_argument("endian must be 'little' or 'big'");
+            }
+            feature.big_endian = endian == "big";
+        } else if (name == "bcd") {
+            feature.bcd = nb::cast<bool>(value);
+        } else if (name == "mask") {
+            feature.mask = nb::cast<uint32_t>(value);
+        } else if (name == "shift") {
+            feature.shift = nb::cast<int>(value);
+        } else if (name == "scale") {
+            feature.scale = nb::cast<float>(value);
+        } else if (name != "name" && name != "description" &&
+                   std::none_of(skip.begin(), skip.end(), [&](const char* own) { return name == own; })) {
+            throw std::invalid_argument("unknown RAM feature key '" + name + "'");
+        }
+    }
+    if (!has_address) {
+        throw std::invalid_argument("every RAM feature needs an address");
+    }
+    return feature;
+}
+
+// RAM feature list from Python, a list of make_feature() dicts. None clears them.
+static std::shared_ptr<const superpy::RamFeatures> make_features(nb::handle features, const std::string& dtype) {
+    superpy::FeatureDtype parsed_dtype = superpy::RamFeature::parse_dtype(dtype);
+    if (features.is_none()) return nullptr;
+
+    std::vector<superpy::RamFeature> parsed;
+    for (nb::handle item : features) {
+        parsed.push_back(make_feature(item));
+    }
+    return std::make_shared<const superpy::RamFeatures>(parsed, parsed_dtype);
+}
+
+// RAM watch list from Python: make_feature() dicts plus kind, length and
+// value. None clears them.
+static std::unique_ptr<superpy::RamWatches> make_watches(nb::handle watches) {
+    if (watches.is_none()) return nullptr;
+
+    std::vector<superpy::RamWatch> parsed;
+    for (nb::handle item : watches) {
+        superpy::RamWatch watch;
+        watch.value = make_feature(item, {"kind", "length", "value"});
+        nb::dict dict = nb::cast<nb::dict>(item);
+        if (dict.contains("kind")) {
+            watch.kind = superpy::RamWatch::parse_kind(nb::cast<std::string>(dict["kind"]));
+        }
+        if (dict.contains("length")) {
+            watch.length = nb::cast<uint32_t>(dict["length"]);
+        }
+        if (dict.contains("value")) {
+            watch.target = nb::cast<int32_t>(dict["value"]);
+        } else if (watch.kind != superpy::WatchKind::Changed) {
+            throw std::invalid_argument("equals, rises and falls watches need a value");
+        }
+        parsed.push_back(watch);
+    }
+    return std::make_unique<superpy::RamWatches>(parsed);
+}
+
+static nb::dlpack::dtype feature_dtype(const superpy::RamFeatures& features) {
+    return features.dtype() == superpy::FeatureDtype::Int32 ? nb::dtype<int32_t>() : nb::dtype<float>();
+}
+
+// Reward program from Python expression strings; all None clears it
+static std::unique_ptr<superpy::RewardProgram> make_reward(const std::optional<std::string>& reward,
+                                                           const std::optional<std::string>& terminated,
+                                                           const std::optional<std::string>& truncated) {
+    if (!reward && !terminated && !truncated) return nullptr;
+    return std::make_unique<superpy::RewardProgram>(reward.value_or(""), terminated.value_or(""),
+                                                    truncated.value_or(""));
+}
+
+template <typename Input>
+static void def_input_overloads(nb::class_<superpy::SuperPyEngine>& cls) {
+    cls.def("step", [](superpy::SuperPyEngine& self, const Input& input) {
+        uint32_t mask = input_mask(input);
+        without_gil(self, [&] { self.step(mask); });
+    }, nb::arg("input"));
+
+    cls.def("tick", [](superpy::SuperPyEngine& self, int count, bool render, const Input& input) {
+        uint32_t mask = input_mask(input);
+        return without_gil(self, [&] { return self.tick(count, render, mask); });
+    }, nb::arg("count"), nb::arg("render"), nb::arg("input"));
+
+    cls.def("step_skip", [](superpy::SuperPyEngine& self, const Input& input,
+                            int frames, const std::string& pool, nb::object out) {
+        bool max_pool = pool_is_max(pool);
+        uint32_t mask = input_mask(input);
+        return observation_into(self, out, [&](void* dst) {
+            self.step_skip(mask, frames, max_pool, dst);
+        });
+    }, nb::arg("input"), nb::arg("frames") = 4, nb::arg("pool") = "max", nb::arg("out") = nb::none());
+}
+
+// 1-D NumPy array owning a copy of values
+template <typename T>
+static nb::ndarray<nb::numpy, T> owned_array(const std::vector<T>& values) {
+    T* data = new T[values.size()];
+    std::copy(values.begin(), values.end(), data);
+    nb::capsule owner(data, [](void* p) noexcept { delete[] static_cast<T*>(p); });
+    size_t shape[1] = {values.size()};
+    return nb::ndarray<nb::numpy, T>(data, 1, shape, owner);
+}
+
+// 1-D NumPy array taking over size values of data
+template <typename T>
+static nb::ndarray<nb::numpy, T> owned_array(std::unique_ptr<T[]> data, size_t size) {
+    nb::capsule owner(data.get(), [](void* p) noexcept { delete[] static_cast<T*>(p); });
+    size_t shape[1] = {size};
+    return nb::ndarray<nb::numpy, T>(data.release(), 1, shape, owner);
+}
+
+// Zero-copy views of the VectorEngine/ForkServer result buffers (keep the
+// owner alive)
+template <typename T>
+static nb::object vector_results(T& self, size_t n) {
+    nb::handle owner = nb::find(self);
+    size_t obs_shape[4] = {n, 0, 0, 0};
+    self.observation_shape(obs_shape + 1);
+    size_t vec_shape[1] = {n};
+
+    return nb::make_tuple(
+        nb::ndarray<nb::numpy>(self.observations(), 4, obs_shape, owner, nullptr,
+                               obs_dtype(self.observation_element_size())),
+        nb::ndarray<nb::numpy, float>(self.rewards(), 1, vec_shape, owner),
+        nb::ndarray<nb::numpy, bool>(self.dones(), 1, vec_shape, owner)
+    );
+}
+
 NB_MODULE(_core, m) {
     m.doc() = "SuperPy: High-performance SNES emulator interface for Python AI research";
 
-    nb::class_<superpy::SuperPyEngine>(m, "Engine")
-        .def(nb::init<>())
-        .def("load_rom", &superpy::SuperPyEngine::load_rom,
-             nb::arg("path"),
+    m.def("observation_shape", [](Crop crop, Size size, const std::string& interpolation,
+                                  const std::string& color, const std::string& layout) {
+        superpy::ObservationPipeline obs(make_spec(crop, size, interpolation, color, layout, false));
+        size_t shape[3];
+        obs.shape(shape);
+        return std::make_tuple(shape[0], shape[1], shape[2]);
+    }, nb::arg("crop") = nb::none(), nb::arg("size") = nb::none(),
+       nb::arg("interpolation") = "nearest", nb::arg("color") = "rgb", nb::arg("layout") = "hwc",
+       "Shape of the observations a given spec produces, without creating an engine");
+
+    m.def("_write_test_rom", &superpy::bench::write_test_rom, nb::arg("path"),
+          "Write the homebrew test ROM (bench/test_rom.h) to `path`; False on I/O errors");
+
+    nb::class_<superpy::SuperPyEngine> engine(m, "Engine");
+    engine
+        .def(nb::init<bool>(), nb::arg("video") = true,
+             "video=False: no-video engine for RAM-only agents; frames are never rendered\n"
+             "(PPU state is still emulated) and screens/observations read as black")
+        .def("load_rom", [](superpy::SuperPyEngine& self, const std::string& path) {
+            return without_gil(self, [&] { return self.load_rom(path); });
+        }, nb::arg("path"),
              "Load a SNES ROM from the given path")
         
         // step() with dict input
         .def("step", [](superpy::SuperPyEngine& self, const std::map<std::string, bool>& input) {
-            uint32_t mask = superpy::SuperPyEngine::buttons_to_mask(input);
-            self.step(mask);
+            uint32_t mask = input_mask(input);
+            without_gil(self, [&] { self.step(mask); });
         }, nb::arg("input") = std::map<std::string, bool>{},
              "Advance emulation by one frame with optional controller input")
         
         // tick() for fast frame skipping
         .def("tick", [](superpy::SuperPyEngine& self, int count, bool render, const std::map<std::string, bool>& input) {
-            uint32_t mask = superpy::SuperPyEngine::buttons_to_mask(input);
-            self.tick(count, render, mask);
+            uint32_t mask = input_mask(input);
+            return without_gil(self, [&] { return self.tick(count, render, mask); });
         }, nb::arg("count") = 1, nb::arg("render") = true, nb::arg("input") = std::map<std::string, bool>{},
-             "Run multiple frames. Set render=False for maximum speed (100x+ real-time)")
+             "Run multiple frames. Set render=False for maximum speed (100x+ real-time).\n"
+             "Stops after the frame on which a watch fires; returns the frames run")
         
-        .def("reset", &superpy::SuperPyEngine::reset,
-             "Reset the emulation to initial state")
+        // step_skip() for frame skipping with pooling in one native call
+        .def("step_skip", [](superpy::SuperPyEngine& self, const std::map<std::string, bool>& input,
+                             int frames, const std::string& pool, nb::object out) {
+            bool max_pool = pool_is_max(pool);
+            uint32_t mask = input_mask(input);
+            return observation_into(self, out, [&](void* dst) {
+                self.step_skip(mask, frames, max_pool, dst);
+            });
+        }, nb::arg("input") = std::map<std::string, bool>{}, nb::arg("frames") = 4,
+             nb::arg("pool") = "max", nb::arg("out") = nb::none(),
+             "Run `frames` frames holding input, rendering only the observed ones, and return\n"
+             "the observation of the last frame ('last') or the max of the last two ('max')")
+        
+        .def("reset", [](superpy::SuperPyEngine& self) {
+            without_gil(self, [&] { self.reset(); });
+        }, "Reset the emulation to initial state")
+        
+        .def("add_reset_state", [](superpy::SuperPyEngine& self) {
+            return without_gil(self, [&] { return self.add_reset_state(); });
+        }, "Record the current state as a start state: reset() then restores start states\n"
+           "in turn instead of power-cycling. Returns its index (-1 on failure)")
+        
+        .def("reset_to", [](superpy::SuperPyEngine& self, int index) {
+            without_gil(self, [&] { self.reset_to(index); });
+        }, nb::arg("index"),
+             "Reset to a specific recorded start state")
+        
+        .def("clear_reset_states", [](superpy::SuperPyEngine& self) {
+            without_gil(self, [&] { self.clear_reset_states(); });
+        }, "Forget the recorded start states (reset() power-cycles again)")
+        
+        .def_prop_ro("reset_state_count", &superpy::SuperPyEngine::reset_state_count,
+             "Number of recorded start states")
+        
+        .def_prop_ro("rom_shared", &superpy::SuperPyEngine::rom_shared,
+             "Whether this engine reads its ROM from the process-wide shared image")
         
         .def_prop_ro("done", &superpy::SuperPyEngine::is_done,
-             "Whether emulation has ended")
+             "Whether the reward program ended the episode (terminated or truncated)")
+        
+        .def_prop_ro("terminated", &superpy::SuperPyEngine::terminated,
+             "Whether the reward program's terminated expression held on a frame this episode")
+        
+        .def_prop_ro("truncated", &superpy::SuperPyEngine::truncated,
+             "Whether the reward program's truncated expression held on a frame this episode")
+        
+        .def("set_reward", [](superpy::SuperPyEngine& self, const std::optional<std::string>& reward,
+                              const std::optional<std::string>& terminated,
+                              const std::optional<std::string>& truncated) {
+            auto program = make_reward(reward, terminated, truncated);
+            without_gil(self, [&] { self.set_reward(std::move(program)); });
+        }, nb::arg("reward") = nb::none(), nb::arg("terminated") = nb::none(), nb::arg("truncated") = nb::none(),
+             "Compile reward/termination expressions over RAM, evaluated natively after every\n"
+             "frame, e.g. reward='delta(bcd24[0x0F34])', terminated='u8[0x0DBE] == 0',\n"
+             "truncated='frame >= 18000'. All None clears them")
+        
+        .def("take_reward", [](superpy::SuperPyEngine& self) {
+            return without_gil(self, [&] { return self.take_reward(); });
+        }, "Reward accumulated since the last call or the episode start")
         
-        .def_prop_ro("frame_count", &superpy::SuperPyEngine::frame_count,
-             "Total frames executed since ROM load")
+        .def("set_watches", [](superpy::SuperPyEngine& self, nb::handle watches) {
+            auto compiled = make_watches(watches);
+            without_gil(self, [&] { self.set_watches(std::move(compiled)); });
+        }, nb::arg("watches").none(),
+             "Check RAM watches after every frame: a list of dicts with address, kind\n"
+             "('changed'|'equals'|'rises'|'falls'), length (changed), value (the others) and\n"
+             "the value keys of set_features. tick() stops on the frame one fires. None clears them")
+        
+        .def_prop_ro("watch_hit", [](superpy::SuperPyEngine& self) -> nb::object {
+            superpy::SuperPyEngine::WatchHit hit = without_gil(self, [&] { return self.watch_hit(); });
+            if (hit.watch < 0) return nb::none();
+            return nb::make_tuple(hit.watch, hit.frame);
+        }, "(watch index, frame_count) of the first watch that fired during the last step(),\n"
+           "tick() or step_skip() call, or None")
+        
+        .def_prop_ro("frame_count", [](superpy::SuperPyEngine& self) {
+            return without_gil(self, [&] { return self.frame_count(); });
+        }, "Frames run in the current episode: load_rom(), reset() and load_state() start it\n"
+           "at 0, rewind() moves it back")
         
         .def_prop_ro("screen", [](superpy::SuperPyEngine& self) {
             // Return screen as numpy array (RGBA, H x W x 4)
-            const uint32_t* data = self.get_screen();
-            int h = self.get_screen_height();
-            int w = self.get_screen_width();
+            const uint32_t* data = nullptr;
+            int h = 0, w = 0;
+            without_gil(self, [&] {
+                data = self.get_screen();
+                h = self.get_screen_height();
+                w = self.get_screen_width();
+            });
             
             // Shape: (height, width, 4) for RGBA
             size_t shape[3] = {(size_t)h, (size_t)w, 4};
             
-            // Zero-copy view into our static buffer
+            // Zero-copy view into this engine's buffer (keeps the engine alive)
             return nb::ndarray<nb::numpy, uint8_t, nb::shape<224, 256, 4>>(
                 (uint8_t*)data,
                 3, shape,
-                nb::handle()
+                nb::find(self)
             );
         }, "Zero-copy view of the SNES screen (224 x 256 x 4 RGBA)")
         
+        .def("set_observation", [](superpy::SuperPyEngine& self, Crop crop, Size size,
+                                   const std::string& interpolation, const std::string& color,
+                                   const std::string& layout, bool full_range) {
+            superpy::ObservationSpec spec = make_spec(crop, size, interpolation, color, layout, full_range);
+            without_gil(self, [&] { self.set_observation(spec); });
+        }, nb::arg("crop") = nb::none(), nb::arg("size") = nb::none(),
+             nb::arg("interpolation") = "nearest", nb::arg("color") = "rgb",
+             nb::arg("layout") = "hwc", nb::arg("full_range") = false,
+             "Configure observe(): crop=(x, y, w, h) in 256x224 coordinates, size=(height, width),\n"
+             "interpolation='nearest'|'area', color='rgb'|'gray'|'rgb565'|'palette', layout='hwc'|'chw'")
+        
+        .def_prop_ro("observation_shape", [](superpy::SuperPyEngine& self) {
+            size_t shape[3];
+            without_gil(self, [&] { self.observation().shape(shape); });
+            return std::make_tuple(shape[0], shape[1], shape[2]);
+        }, "Shape of the arrays produced by observe()")
+        
+        .def("observe", [](superpy::SuperPyEngine& self, nb::object out) {
+            return observation_into(self, out, [&](void* dst) {
+                self.observe(dst);
+            });
+        }, nb::arg("out") = nb::none(),
+             "Apply the observation spec to the current frame, into `out` if given")
+        
+        .def_prop_ro("video", &superpy::SuperPyEngine::video,
+             "False for no-video engines")
+        
+        .def_prop_rw("full_range_color",
+             &superpy::SuperPyEngine::full_range_color,
+             &superpy::SuperPyEngine::set_full_range_color,
+             "Expand colors to the full 0-255 range (bit replication) instead of plain shifts")
+        
+        .def_prop_rw("profiling", &superpy::SuperPyEngine::profiling,
+             [](superpy::SuperPyEngine& self, bool enabled) {
+                 without_gil(self, [&] { self.set_profiling(enabled); });
+             },
+             "Split every frame's time between cpu/ppu/apu/dma/sa1/superfx and the screen\n"
+             "conversion (see profile_stats()); enabling or disabling clears the stats")
+        
+        .def("profile_stats", [](superpy::SuperPyEngine& self) {
+            superpy::FrameProfiler::Stats stats[superpy::PROFILE_COUNT + 1];
+            size_t frames = without_gil(self, [&] { return self.profiler().stats(stats); });
+            nb::dict result;
+            for (int s = 0; s <= superpy::PROFILE_COUNT; s++) {
+                nb::dict entry;
+                entry["mean_us"] = stats[s].mean_us;
+                entry["p50_us"] = stats[s].p50_us;
+                entry["p99_us"] = stats[s].p99_us;
+                result[s < superpy::PROFILE_COUNT ? superpy::FrameProfiler::NAMES[s] : "total"] = entry;
+            }
+            result["frames"] = frames;
+            return result;
+        }, "Microseconds per frame (mean_us, p50_us, p99_us) for each subsystem and the\n"
+           "whole frame ('total') over the last frames profiled, and their count ('frames')")
+        
+        .def("reset_profile", [](superpy::SuperPyEngine& self) {
+            without_gil(self, [&] { self.profiler().clear(); });
+        }, "Forget the frames profiled so far")
+        
+        .def("trace_memory", [](superpy::SuperPyEngine& self, uint32_t address, uint32_t length,
+                                bool reads, bool writes) {
+            uint8_t flags = (reads ? superpy::TRACE_READ : 0) | (writes ? superpy::TRACE_WRITE : 0);
+            without_gil(self, [&] { self.trace_memory(address, length, flags); });
+        }, nb::arg("address"), nb::arg("length") = 1, nb::arg("reads") = false, nb::arg("writes") = true,
+             "Record 65816 reads and/or writes of `length` WRAM bytes from address into the\n"
+             "trace ring (see trace_events()); adds to the bytes already traced")
+        
+        .def("clear_trace", [](superpy::SuperPyEngine& self) {
+            without_gil(self, [&] { self.clear_trace(); });
+        }, "Stop tracing memory accesses and drop pending events")
+        
+        .def_prop_rw("trace_capacity", [](superpy::SuperPyEngine& self) {
+                 return without_gil(self, [&] { return self.trace_capacity(); });
+             },
+             [](superpy::SuperPyEngine& self, size_t events) {
+                 without_gil(self, [&] { self.set_trace_capacity(events); });
+             },
+             "Events kept in the trace ring, oldest overwritten first (drops pending events)")
+        
+        .def_prop_ro("trace_lost", [](superpy::SuperPyEngine& self) {
+            return without_gil(self, [&] { return self.trace_lost(); });
+        }, "Events overwritten before trace_events() took them")
+        
+        .def("trace_events", [](superpy::SuperPyEngine& self) {
+            size_t count = 0;
+            std::unique_ptr<uint32_t[]> address, value, pc, frame;
+            std::unique_ptr<uint16_t[]> scanline;
+            std::unique_ptr<uint8_t[]> size, write;
+            without_gil(self, [&] {
+                // Sized to the pending events, then filled a chunk at a time
+                size_t pending = self.trace_pending();
+                address.reset(new uint32_t[pending]);
+                value.reset(new uint32_t[pending]);
+                pc.reset(new uint32_t[pending]);
+                frame.reset(new uint32_t[pending]);
+                scanline.reset(new uint16_t[pending]);
+                size.reset(new uint8_t[pending]);
+                write.reset(new uint8_t[pending]);
+
+                superpy::MemoryAccess chunk[256];
+                while (count < pending) {
+                    size_t taken = self.take_trace(chunk, std::min(pending - count, std::size(chunk)));
+                    if (taken == 0) break;
+                    for (size_t i = 0; i < taken; i++, count++) {
+                        address[count] = chunk[i].address;
+                        value[count] = chunk[i].value;
+                        pc[count] = chunk[i].pc;
+                        frame[count] = chunk[i].frame;
+                        scanline[count] = chunk[i].scanline;
+                        size[count] = chunk[i].size;
+                        write[count] = chunk[i].flags == superpy::TRACE_WRITE;
+                    }
+                }
+            });
+
+            nb::dict result;
+            result["address"] = owned_array(std::move(address), count);
+            result["value"] = owned_array(std::move(value), count);
+            result["pc"] = owned_array(std::move(pc), count);
+            result["frame"] = owned_array(std::move(frame), count);
+            result["scanline"] = owned_array(std::move(scanline), count);
+            result["size"] = owned_array(std::move(size), count);
+            result["write"] = owned_array(std::move(write), count);
+            return result;
+        }, "Take the traced accesses, oldest first, as arrays: address (WRAM offset), value,\n"
+           "pc (bank:PC past the instruction's operand), frame, scanline, size (1|2) and\n"
+           "write (1 for writes, 0 for reads)")
+        
+        .def("set_features", [](superpy::SuperPyEngine& self, nb::handle features, const std::string& dtype) {
+            auto compiled = make_features(features, dtype);
+            without_gil(self, [&] { self.set_features(compiled); });
+        }, nb::arg("features").none(), nb::arg("dtype") = "float32",
+             "Compile RAM features read by features(): a list of dicts with address, type\n"
+             "('u8'|'s8'|'u16'|'s16'|'u24'), endian ('little'|'big'), bcd, mask, shift and\n"
+             "scale; dtype='float32'|'int32'. None clears them")
+        
+        .def("features", [](superpy::SuperPyEngine& self, nb::object out) {
+            std::shared_ptr<const superpy::RamFeatures> features;
+            without_gil(self, [&] { features = self.features(); });
+            if (!features) {
+                throw std::runtime_error("no RAM features set; call set_features() first");
+            }
+
+            nb::object result = out;
+            void* dst = nullptr;
+            if (out.is_none()) {
+                uint8_t* data = new uint8_t[features->size_bytes()];
+                nb::capsule owner(data, [](void* p) noexcept { delete[] static_cast<uint8_t*>(p); });
+                size_t shape[1] = {features->size()};
+                result = nb::cast(nb::ndarray<nb::numpy>(data, 1, shape, owner, nullptr, feature_dtype(*features)));
+                dst = data;
+            } else {
+                auto buffer = nb::cast<nb::ndarray<nb::c_contig, nb::device::cpu>>(out);
+                if (buffer.nbytes() != features->size_bytes() || buffer.dtype() != feature_dtype(*features)) {
+                    throw std::invalid_argument("out must be a C-contiguous array of the feature count and dtype");
+                }
+                dst = buffer.data();
+            }
+
+            bool written = without_gil(self, [&] {
+                // The features may have been replaced by another thread meanwhile
+                if (self.features() != features) return false;
+                self.gather_features(dst);
+                return true;
+            });
+            if (!written) {
+                throw std::runtime_error("RAM features changed during the call");
+            }
+            return result;
+        }, nb::arg("out") = nb::none(),
+             "Gather the RAM features of the current frame into a 1-D float32/int32 array")
+        
         .def_prop_ro("memory", [](superpy::SuperPyEngine& self) {
             // Return RAM as numpy array (128KB)
             uint8_t* data = self.get_memory();
@@ -72,18 +648,507 @@ NB_MODULE(_core, m) {
             return nb::ndarray<nb::numpy, uint8_t>(
                 data,
                 1, shape,
-                nb::handle()
+                nb::find(self)
             );
         }, "Direct access to SNES RAM (128KB)")
         
+        .def("mark_ram", [](superpy::SuperPyEngine& self) {
+            without_gil(self, [&] { self.mark_ram(); });
+        }, "Take the reference copy of RAM that ram_diff() compares against")
+        
+        .def("ram_diff", [](superpy::SuperPyEngine& self, bool advance, std::optional<size_t> max_changes) {
+            size_t count = 0;
+            std::unique_ptr<uint32_t[]> indices;
+            std::unique_ptr<uint8_t[]> old_values, new_values;
+            without_gil(self, [&] {
+                // Diff into the engine's scratch, then copy only what is returned
+                size_t max = std::min(max_changes.value_or(self.get_memory_size()), self.get_memory_size());
+                count = std::min(self.diff_ram(max, advance), max);
+                indices.reset(new uint32_t[count]);
+                old_values.reset(new uint8_t[count]);
+                new_values.reset(new uint8_t[count]);
+                std::copy(self.ram_diff_indices(), self.ram_diff_indices() + count, indices.get());
+                std::copy(self.ram_diff_old(), self.ram_diff_old() + count, old_values.get());
+                std::copy(self.ram_diff_new(), self.ram_diff_new() + count, new_values.get());
+            });
+            return nb::make_tuple(
+                owned_array(std::move(indices), count),
+                owned_array(std::move(old_values), count),
+                owned_array(std::move(new_values), count)
+            );
+        }, nb::arg("advance") = false, nb::arg("max_changes") = nb::none(),
+             "RAM bytes changed since mark_ram() as (indices, old, new) arrays in address\n"
+             "order, at most max_changes of them. advance=True makes the current RAM the new\n"
+             "reference (changes since the last call). Marks and returns empty arrays if\n"
+             "there is no reference yet")
+        
         .def("save_state", [](superpy::SuperPyEngine& self) {
-            auto state = self.save_state();
-            return nb::bytes(reinterpret_cast<const char*>(state.data()), state.size());
+            size_t size = without_gil(self, [&] { return self.state_size(); });
+            if (size == 0) return nb::bytes();
+
+            // Serialize straight into a fresh bytes object, before anyone can see it
+            nb::bytes state(nullptr, size);
+            uint8_t* data = reinterpret_cast<uint8_t*>(PyBytes_AsString(state.ptr()));
+            bool ok = without_gil(self, [&] { return self.save_state_into(data, size); });
+            return ok ? state : nb::bytes();
         }, "Save current emulator state to bytes")
         
+        .def("save_state_into", [](superpy::SuperPyEngine& self, StateBuffer buffer) {
+            return without_gil(self, [&] {
+                size_t size = self.state_size();
+                if (buffer.nbytes() < size) {
+                    throw std::invalid_argument("buffer is smaller than state_size()");
+                }
+                return self.save_state_into(static_cast<uint8_t*>(buffer.data()), size) ? size : 0;
+            });
+        }, nb::arg("buffer"),
+             "Save the state into a writable contiguous buffer (bytearray, NumPy array, ...)\n"
+             "of at least state_size() bytes. Returns the number of bytes written (0 on failure)")
+        
+        .def("state_size", [](superpy::SuperPyEngine& self) {
+            return without_gil(self, [&] { return self.state_size(); });
+        }, "Size in bytes of a saved state (0 without a ROM)")
+        
         .def("load_state", [](superpy::SuperPyEngine& self, nb::bytes state) {
-            std::vector<uint8_t> data(state.c_str(), state.c_str() + state.size());
-            return self.load_state(data);
+            // bytes are immutable, so they can be read in place without the GIL
+            const uint8_t* data = reinterpret_cast<const uint8_t*>(state.c_str());
+            return without_gil(self, [&] { return self.load_state(data, state.size()); });
         }, nb::arg("state"),
-             "Load emulator state from bytes");
+             "Load emulator state from bytes or any contiguous buffer, without copying")
+        .def("load_state", [](superpy::SuperPyEngine& self, ConstStateBuffer state) {
+            const uint8_t* data = static_cast<const uint8_t*>(state.data());
+            return without_gil(self, [&] { return self.load_state(data, state.nbytes()); });
+        }, nb::arg("state"))
+        
+        .def("enable_rewind", [](superpy::SuperPyEngine& self, int depth, int stride, size_t buffer_size) {
+            return without_gil(self, [&] { return self.enable_rewind(depth, stride, buffer_size); });
+        }, nb::arg("depth") = 600, nb::arg("stride") = 1, nb::arg("buffer_size") = 0,
+             "Keep a native delta-compressed rewind ring: a snapshot every `stride` frames,\n"
+             "the newest `depth` kept, in a ring of buffer_size bytes (0 = estimate)")
+        
+        .def("disable_rewind", [](superpy::SuperPyEngine& self) {
+            without_gil(self, [&] { self.disable_rewind(); });
+        }, "Stop recording rewind snapshots and free the ring")
+        
+        .def("rewind", [](superpy::SuperPyEngine& self, uint32_t frames) {
+            return without_gil(self, [&] { return self.rewind(frames); });
+        }, nb::arg("frames"),
+             "Go back at least `frames` frames (or as far as the ring reaches).\n"
+             "Returns the number of frames rewound, 0 if nothing was recorded")
+        
+        .def_prop_ro("rewind_available", &superpy::SuperPyEngine::rewind_available,
+             "Number of rewind snapshots currently recorded")
+        
+        .def("set_action_table", [](superpy::SuperPyEngine& self, const std::vector<uint32_t>& masks) {
+            self.set_action_table(action_table(masks));
+        }, nb::arg("masks"),
+             "Register discrete actions: action index i -> joypad mask masks[i]")
+        
+        .def_prop_ro("action_table", &superpy::SuperPyEngine::action_table,
+             "Joypad masks of the registered discrete actions")
+        
+        .def("action_mask", &superpy::SuperPyEngine::action_mask, nb::arg("index"),
+             "Joypad mask of a discrete action index")
+        
+        .def("step_action", [](superpy::SuperPyEngine& self, int64_t index) {
+            without_gil(self, [&] { self.step_action(index); });
+        }, nb::arg("index"),
+             "step() holding the joypad mask of a discrete action index")
+        
+        .def("tick_action", [](superpy::SuperPyEngine& self, int64_t index, int count, bool render) {
+            return without_gil(self, [&] { return self.tick_action(index, count, render); });
+        }, nb::arg("index"), nb::arg("count") = 1, nb::arg("render") = true,
+             "tick() holding the joypad mask of a discrete action index")
+        
+        .def("step_skip_action", [](superpy::SuperPyEngine& self, int64_t index, int frames,
+                                    const std::string& pool, nb::object out) {
+            bool max_pool = pool_is_max(pool);
+            return observation_into(self, out, [&](void* dst) {
+                self.step_skip(self.action_mask(index), frames, max_pool, dst);
+            });
+        }, nb::arg("index"), nb::arg("frames") = 4, nb::arg("pool") = "max", nb::arg("out") = nb::none(),
+             "step_skip() holding the joypad mask of a discrete action index")
+        
+        .def_static("buttons_to_mask", [](const std::map<std::string, bool>& buttons) {
+            return input_mask(buttons);
+        }, nb::arg("buttons"),
+             "Joypad mask of a button dict or a MultiBinary(12) array")
+        .def_static("buttons_to_mask", [](Buttons buttons) {
+            return input_mask(buttons);
+        }, nb::arg("buttons"));
+
+    // Allocation-free input forms: raw uint32 joypad mask and MultiBinary(12)
+    // arrays. Registered after the dict overloads, whose defaults and
+    // docstrings they share.
+    def_input_overloads<uint32_t>(engine);
+    def_input_overloads<Buttons>(engine);
+
+    nb::class_<superpy::StatePool>(m, "StatePool")
+        .def(nb::init<superpy::SuperPyEngine&, int>(), nb::arg("engine"), nb::arg("slots"),
+             nb::keep_alive<1, 2>(),
+             "Preallocate `slots` snapshot slots of state_size() bytes for engine (ROM loaded)")
+        
+        .def("save", [](superpy::StatePool& self, int slot) {
+            return without_gil(self.engine(), [&] { return self.save(slot); });
+        }, nb::arg("slot"),
+             "Snapshot the engine into a slot")
+        
+        .def("restore", [](superpy::StatePool& self, int slot) {
+            return without_gil(self.engine(), [&] { return self.restore(slot); });
+        }, nb::arg("slot"),
+             "Load a slot back into the engine; False if the slot is empty")
+        
+        .def("occupied", &superpy::StatePool::occupied, nb::arg("slot"),
+             "Whether a slot holds a snapshot")
+        
+        .def("clear", &superpy::StatePool::clear, nb::arg("slot"),
+             "Mark a slot as empty")
+        
+        .def("view", [](superpy::StatePool& self, int slot) {
+            size_t shape[1] = {self.state_size()};
+            return nb::ndarray<nb::numpy, uint8_t>(self.slot_data(slot), 1, shape, nb::find(self));
+        }, nb::arg("slot"),
+             "Zero-copy view of a slot's snapshot bytes (e.g. to archive it)")
+        
+        .def("__len__", &superpy::StatePool::capacity)
+        
+        .def_prop_ro("capacity", &superpy::StatePool::capacity,
+             "Number of slots")
+        
+        .def_prop_ro("state_size", &superpy::StatePool::state_size,
+             "Size in bytes of each snapshot");
+
+    nb::class_<superpy::DeltaArchive>(m, "DeltaArchive")
+        .def(nb::init<superpy::SuperPyEngine&, int>(), nb::arg("engine"), nb::arg("keyframe_interval") = 32,
+             nb::keep_alive<1, 2>(),
+             "Archive of snapshots stored as XOR/RLE deltas against their parent, with a\n"
+             "keyframe at least every keyframe_interval links")
+        
+        .def("save", [](superpy::DeltaArchive& self, std::optional<int> parent) {
+            return without_gil(self.engine(), [&] { return self.save(parent.value_or(-1)); });
+        }, nb::arg("parent") = nb::none(),
+             "Snapshot the engine as a delta against `parent` (None = keyframe). Returns the new id")
+        
+        .def("restore", [](superpy::DeltaArchive& self, int id) {
+            return without_gil(self.engine(), [&] { return self.restore(id); });
+        }, nb::arg("id"),
+             "Reconstruct a snapshot and load it into the engine")
+        
+        .def("parent", [](superpy::DeltaArchive& self, int id) -> std::optional<int> {
+            int parent = self.parent(id);
+            return parent < 0 ? std::nullopt : std::optional<int>(parent);
+        }, nb::arg("id"),
+             "Parent id of a snapshot (None for keyframes)")
+        
+        .def("snapshot_bytes", &superpy::DeltaArchive::snapshot_bytes, nb::arg("id"),
+             "Stored size of one snapshot")
+        
+        .def("__len__", &superpy::DeltaArchive::size)
+        
+        .def_prop_ro("memory_bytes", &superpy::DeltaArchive::memory_bytes,
+             "Stored size of the whole archive")
+        
+        .def_prop_ro("keyframe_interval", &superpy::DeltaArchive::keyframe_interval,
+             "Maximum number of deltas applied by restore()")
+        
+        .def_prop_ro("state_size", &superpy::DeltaArchive::state_size,
+             "Size in bytes of a full snapshot");
+
+    nb::class_<superpy::VectorEngine>(m, "VectorEngine")
+        .def(nb::init<int, int, bool>(), nb::arg("num_envs"), nb::arg("num_threads") = 0,
+             nb::arg("video") = true,
+             "Create num_envs independent engines stepped on num_threads threads (0 = all cores);\n"
+             "video=False creates no-video engines (see Engine)")
+        .def("load_rom", [](superpy::VectorEngine& self, const std::string& path) {
+            return without_gil(self, [&] { return self.load_rom(path); });
+        }, nb::arg("path"),
+             "Load the same SNES ROM into every engine")
+        
+        .def("step", [](superpy::VectorEngine& self, Actions actions, int frames, const std::string& pool) {
+            if (actions.shape(0) != (size_t)self.num_envs()) {
+                throw std::invalid_argument("actions must have one joypad mask per engine");
+            }
+            if (frames < 1) {
+                throw std::invalid_argument("frames must be at least 1");
+            }
+            bool max_pool = pool_is_max(pool);
+            without_gil(self, [&] { self.step(actions.data(), frames, max_pool); });
+            return vector_results(self, self.num_envs());
+        }, nb::arg("actions"), nb::arg("frames") = 1, nb::arg("pool") = "last",
+             "Advance every engine by `frames` frames in parallel. pool='max' pools the last\n"
+             "two frames (needs set_observation(), ValueError otherwise).\n"
+             "Returns (observations (N, ...), rewards (N,), dones (N,)) as views into\n"
+             "buffers that stay valid for one more call (two sets alternate)")
+        
+        .def("step_async", [](superpy::VectorEngine& self, Actions actions, int frames, const std::string& pool) {
+            if (actions.shape(0) != (size_t)self.num_envs()) {
+                throw std::invalid_argument("actions must have one joypad mask per engine");
+            }
+            if (frames < 1) {
+                throw std::invalid_argument("frames must be at least 1");
+            }
+            bool max_pool = pool_is_max(pool);
+            without_gil(self, [&] { self.step_async(actions.data(), frames, max_pool); });
+        }, nb::arg("actions"), nb::arg("frames") = 1, nb::arg("pool") = "last",
+             "Start step() on a background thread and return immediately. The results of\n"
+             "the previous call stay valid while it runs; collect the new ones with step_wait()")
+        
+        .def("step_wait", [](superpy::VectorEngine& self) {
+            without_gil(self, [&] { self.step_wait(); });
+            return vector_results(self, self.num_envs());
+        }, "Wait for the pending step_async() and return its (observations, rewards, dones)")
+        
+        .def_prop_ro("step_pending", &superpy::VectorEngine::step_pending,
+             "Whether a step_async() is waiting for step_wait()")
+        
+        .def("results", [](superpy::VectorEngine& self) {
+            return vector_results(self, self.num_envs());
+        }, "Views of the current (observations, rewards, dones) without stepping. While a\n"
+           "step_async() is pending these are still the previous batch's")
+        
+        .def("step_discrete", [](superpy::VectorEngine& self, ActionIndices indices, int frames,
+                                 const std::string& pool) {
+            if (indices.shape(0) != (size_t)self.num_envs()) {
+                throw std::invalid_argument("indices must have one action index per engine");
+            }
+            if (frames < 1) {
+                throw std::invalid_argument("frames must be at least 1");
+            }
+            bool max_pool = pool_is_max(pool);
+            without_gil(self, [&] { self.step_discrete(indices.data(), frames, max_pool); });
+            return vector_results(self, self.num_envs());
+        }, nb::arg("indices"), nb::arg("frames") = 1, nb::arg("pool") = "last",
+             "step() with actions[i] = action_table[indices[i]], resolved natively")
+        
+        .def("set_action_table", [](superpy::VectorEngine& self, const std::vector<uint32_t>& masks) {
+            std::vector<uint32_t> table = action_table(masks);
+            without_gil(self, [&] { self.set_action_table(table); });
+        }, nb::arg("masks"),
+             "Register discrete actions for step_discrete(): index i -> joypad mask masks[i]")
+        
+        .def_prop_ro("action_table", [](superpy::VectorEngine& self) {
+            return without_gil(self, [&] { return self.action_table(); });
+        }, "Joypad masks of the registered discrete actions")
+        
+        .def("reset", [](superpy::VectorEngine& self) {
+            without_gil(self, [&] { self.reset(); });
+            return vector_results(self, self.num_envs());
+        }, "Reset every engine and return the initial (observations, rewards, dones)")
+        
+        .def("add_reset_state", [](superpy::VectorEngine& self) {
+            return without_gil(self, [&] { return self.add_reset_state(); });
+        }, "Record every engine's current state as a start state for reset()")
+        
+        .def("set_observation", [](superpy::VectorEngine& self, Crop crop, Size size,
+                                   const std::string& interpolation, const std::string& color,
+                                   const std::string& layout, bool full_range) {
+            superpy::ObservationSpec spec = make_spec(crop, size, interpolation, color, layout, full_range);
+            without_gil(self, [&] { self.set_observation(spec); });
+        }, nb::arg("crop") = nb::none(), nb::arg("size") = nb::none(),
+             nb::arg("interpolation") = "nearest", nb::arg("color") = "rgb",
+             nb::arg("layout") = "hwc", nb::arg("full_range") = false,
+             "Produce observations through the native pipeline (see Engine.set_observation)")
+        
+        .def("set_features", [](superpy::VectorEngine& self, nb::handle features, const std::string& dtype) {
+            auto compiled = make_features(features, dtype);
+            without_gil(self, [&] { self.set_features(compiled); });
+        }, nb::arg("features").none(), nb::arg("dtype") = "float32",
+             "Gather RAM features (see Engine.set_features) into `features` after every\n"
+             "step() and reset(). None clears them")
+        
+        .def_prop_ro("features", [](superpy::VectorEngine& self) {
+            const auto& features = self.features_spec();
+            if (!features) {
+                throw std::runtime_error("no RAM features set; call set_features() first");
+            }
+            size_t shape[2] = {static_cast<size_t>(self.num_envs()), features->size()};
+            return nb::ndarray<nb::numpy>(self.features(), 2, shape, nb::find(self), nullptr,
+                                          feature_dtype(*features));
+        }, "Zero-copy (num_envs, num_features) view of the RAM features of the latest\n"
+           "batch, next to the arrays step() returns")
+        
+        .def("set_reward", [](superpy::VectorEngine& self, const std::optional<std::string>& reward,
+                              const std::optional<std::string>& terminated,
+                              const std::optional<std::string>& truncated) {
+            auto program = make_reward(reward, terminated, truncated);
+            without_gil(self, [&] { self.set_reward(program.get()); });
+        }, nb::arg("reward") = nb::none(), nb::arg("terminated") = nb::none(), nb::arg("truncated") = nb::none(),
+             "Give every engine the reward program (see Engine.set_reward): step() then\n"
+             "returns its rewards and dones. All None clears it")
+        
+        .def_prop_ro("truncated", [](superpy::VectorEngine& self) {
+            size_t shape[1] = {static_cast<size_t>(self.num_envs())};
+            return nb::ndarray<nb::numpy, bool>(self.truncated(), 1, shape, nb::find(self));
+        }, "Zero-copy (num_envs,) view of which dones of the latest batch are truncations")
+        
+        .def("env_costs", [](superpy::VectorEngine& self) {
+            std::vector<float> mean_us, last_us;
+            std::vector<double> total_us;
+            std::vector<uint64_t> steps;
+            without_gil(self, [&] {
+                if (self.step_pending()) {
+                    throw std::runtime_error("step_async() is pending; call step_wait() first");
+                }
+                for (const auto& cost : self.env_costs()) {
+                    mean_us.push_back(cost.mean_us);
+                    last_us.push_back(cost.last_us);
+                    total_us.push_back(cost.total_us);
+                    steps.push_back(cost.steps);
+                }
+            });
+            nb::dict costs;
+            costs["mean_us"] = owned_array(mean_us);
+            costs["last_us"] = owned_array(last_us);
+            costs["total_us"] = owned_array(total_us);
+            costs["steps"] = owned_array(steps);
+            return costs;
+        }, "Per-env step cost: mean_us/last_us (microseconds per frame, mean is a moving\n"
+           "average), total_us and steps, one entry per engine")
+        
+        .def("reset_env_costs", [](superpy::VectorEngine& self) {
+            without_gil(self, [&] { self.reset_env_costs(); });
+        }, "Forget the measured costs (e.g. after switching scenes)")
+        
+        .def_prop_rw("cost_scheduling", &superpy::VectorEngine::cost_scheduling,
+             [](superpy::VectorEngine& self, bool enabled) {
+                 without_gil(self, [&] { self.set_cost_scheduling(enabled); });
+             },
+             "Deal envs to threads by measured cost (default) instead of in equal\n"
+             "contiguous shares; idle threads steal work either way")
+        
+        .def_prop_ro("steals", &superpy::VectorEngine::steals,
+             "Env steps run by a thread other than the one they were dealt to")
+        
+        .def("__len__", &superpy::VectorEngine::num_envs)
+        
+        .def("__getitem__", [](superpy::VectorEngine& self, int index) -> superpy::SuperPyEngine& {
+            if (index < 0) index += self.num_envs();
+            if (index < 0 || index >= self.num_envs()) {
+                throw nb::index_error("engine index out of range");
+            }
+            return self.engine(index);
+        }, nb::rv_policy::reference_internal,
+             "Access a single engine (e.g. for its memory)")
+        
+        .def_prop_ro("num_envs", &superpy::VectorEngine::num_envs,
+             "Number of engines")
+        
+        .def_prop_ro("num_threads", &superpy::VectorEngine::num_threads,
+             "Number of threads stepping the engines");
+
+    nb::class_<superpy::ForkServer>(m, "ForkServer")
+        .def("__init__", [](superpy::ForkServer* self, superpy::SuperPyEngine& engine, int num_workers) {
+            // Fork from a consistent engine: no other thread may be stepping it
+            without_gil(engine, [&] { new (self) superpy::ForkServer(engine, num_workers); });
+        }, nb::arg("engine"), nb::arg("num_workers"),
+             "Fork num_workers worker processes, each starting from a copy-on-write copy of\n"
+             "engine as it is now (ROM, warm state, observation spec). POSIX only")
+        
+        .def("step", [](superpy::ForkServer& self, Actions actions, int frames, const std::string& pool) {
+            if (actions.shape(0) != (size_t)self.num_workers()) {
+                throw std::invalid_argument("actions must have one joypad mask per worker");
+            }
+            if (frames < 1) {
+                throw std::invalid_argument("frames must be at least 1");
+            }
+            bool max_pool = pool_is_max(pool);
+            without_gil(self, [&] { self.step(actions.data(), frames, max_pool); });
+            return vector_results(self, self.num_workers());
+        }, nb::arg("actions"), nb::arg("frames") = 1, nb::arg("pool") = "last",
+             "Advance every worker by `frames` frames, each in its own process.\n"
+             "Returns (observations (N, ...), rewards (N,), dones (N,)) as views\n"
+             "into shared buffers that the next call overwrites")
+        
+        .def("reset", [](superpy::ForkServer& self) {
+            without_gil(self, [&] { self.reset(); });
+            return vector_results(self, self.num_workers());
+        }, "Reset every worker and return the initial (observations, rewards, dones)")
+        
+        .def("close", [](superpy::ForkServer& self) {
+            without_gil(self, [&] { self.close(); });
+        }, "Stop and reap the worker processes (also done on garbage collection)")
+        
+        .def("__enter__", [](nb::object self) { return self; })
+        
+        .def("__exit__", [](superpy::ForkServer& self, nb::args) {
+            without_gil(self, [&] { self.close(); });
+        })
+        
+        .def("__len__", &superpy::ForkServer::num_workers)
+        
+        .def_prop_ro("num_workers", &superpy::ForkServer::num_workers,
+             "Number of worker processes")
+        
+        .def_prop_ro("closed", &superpy::ForkServer::closed,
+             "Whether the workers have been stopped");
+
+    nb::class_<superpy::ObservationRing>(m, "ObservationRing")
+        .def("__init__", [](superpy::ObservationRing* self, const std::string& name, int num_envs, int depth,
+                            const std::vector<uint32_t>& ram_addresses, Crop crop, Size size,
+                            const std::string& interpolation, const std::string& color,
+                            const std::string& layout, bool full_range) {
+            superpy::ObservationSpec spec = make_spec(crop, size, interpolation, color, layout, full_range);
+            new (self) superpy::ObservationRing(name, num_envs, depth, spec, ram_addresses);
+        }, nb::arg("name"), nb::arg("num_envs"), nb::arg("depth") = 2,
+             nb::arg("ram_addresses") = std::vector<uint32_t>(), nb::arg("crop") = nb::none(),
+             nb::arg("size") = nb::none(), nb::arg("interpolation") = "nearest", nb::arg("color") = "rgb",
+             nb::arg("layout") = "hwc", nb::arg("full_range") = false,
+             "Create a named shared-memory ring of `depth` result batches for num_envs worker\n"
+             "processes (learner side). Observations follow the given spec (see\n"
+             "Engine.set_observation); the bytes at ram_addresses are gathered on every push")
+        
+        .def_static("attach", [](const std::string& name) {
+            return new superpy::ObservationRing(name);
+        }, nb::arg("name"), nb::rv_policy::take_ownership,
+             "Attach to a ring created by another process (worker side)")
+        
+        .def("push", [](superpy::ObservationRing& self, int env, superpy::SuperPyEngine& engine, float reward,
+                        bool done, std::optional<double> timeout) {
+            int ms = timeout_ms(timeout);
+            return without_gil(engine, [&] { return self.push(env, engine, reward, done, ms); });
+        }, nb::arg("env"), nb::arg("engine"), nb::arg("reward") = 0.0f, nb::arg("done") = false,
+             nb::arg("timeout") = nb::none(),
+             "Write the engine's current observation, RAM bytes, reward and done into env's\n"
+             "next slot. Blocks while the learner is `depth` batches behind; False on timeout")
+        
+        .def("wait", [](superpy::ObservationRing& self, std::optional<double> timeout) -> nb::object {
+            int ms = timeout_ms(timeout);
+            if (!without_gil(self, [&] { return self.wait(ms); })) {
+                return nb::none();
+            }
+            nb::handle owner = nb::find(self);
+            size_t n = self.num_envs();
+            size_t obs_shape[4] = {n, 0, 0, 0};
+            self.observation_shape(obs_shape + 1);
+            size_t ram_shape[2] = {n, self.ram_count()};
+            size_t vec_shape[1] = {n};
+            return nb::make_tuple(
+                nb::ndarray<nb::numpy>(self.observations(), 4, obs_shape, owner, nullptr,
+                                       obs_dtype(self.observation_element_size())),
+                nb::ndarray<nb::numpy, uint8_t>(self.ram(), 2, ram_shape, owner),
+                nb::ndarray<nb::numpy, float>(self.rewards(), 1, vec_shape, owner),
+                nb::ndarray<nb::numpy, bool>(self.dones(), 1, vec_shape, owner)
+            );
+        }, nb::arg("timeout") = nb::none(),
+             "Wait for every env to push the current batch and return (observations (N, ...),\n"
+             "ram (N, K), rewards (N,), dones (N,)) as views into shared memory, valid until\n"
+             "release(). None on timeout")
+        
+        .def("release", [](superpy::ObservationRing& self) {
+            without_gil(self, [&] { self.release(); });
+        }, "Hand the current batch's slots back to the workers")
+        
+        .def("__len__", &superpy::ObservationRing::num_envs)
+        
+        .def_prop_ro("name", &superpy::ObservationRing::name,
+             "Shared memory segment name")
+        
+        .def_prop_ro("num_envs", &superpy::ObservationRing::num_envs,
+             "Number of environments (worker slots)")
+        
+        .def_prop_ro("depth", &superpy::ObservationRing::depth,
+             "Number of batches workers may run ahead of the learner")
+        
+        .def_prop_ro("batch", &superpy::ObservationRing::batch,
+             "Index of the batch wait() returns next");
 }
@@ -0,0 +1,215 @@
+/**
+ * SuperPy Core Loader
+ *
+ * Every SuperPyEngine gets its own copy of the core library mapped into the
+ * process. Dynamic loaders deduplicate by file, so the first engine loads the
+ * installed library directly and every further engine loads a temporary
+ * duplicate of it. The core library is built with hidden visibility, so each
+ * copy binds to its own globals and never to another copy's.
+ */
+
+#include "core_loader.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <process.h>
+#else
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
+
+#ifndef SUPERPY_CORE_LIBRARY
+#error "SUPERPY_CORE_LIBRARY must name the core library file"
+#endif
+
+namespace superpy {
+
+namespace {
+
+std::mutex loader_mutex;
+bool in_place_loaded = false;   // installed file currently mapped by us
+std::atomic<unsigned> copy_counter{0};
+
+// Any symbol inside this module; used to find the directory we live in.
+void module_anchor() {}
+
+std::string module_directory() {
+#if defined(_WIN32)
+    HMODULE module = nullptr;
+    GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                       GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                       reinterpret_cast<LPCSTR>(&module_anchor), &module);
+    char path[MAX_PATH];
+    DWORD len = GetModuleFileNameA(module, path, MAX_PATH);
+    std::string file(path, len);
+    size_t slash = file.find_last_of("\\/");
+#else
+    Dl_info info;
+    if (!dladdr(reinterpret_cast<void*>(&module_anchor), &info) || !info.dli_fname) {
+        return ".";
+    }
+    std::string file = info.dli_fname;
+    size_t slash = file.find_last_of('/');
+#endif
+    return slash == std::string::npos ? "." : file.substr(0, slash);
+}
+
+std::string temp_directory() {
+#if defined(_WIN32)
+    char path[MAX_PATH];
+    DWORD len = GetTempPathA(MAX_PATH, path);
+    return len > 0 ? std::string(path, len) : std::string(".\\");
+#else
+    const char* dir = std::getenv("TMPDIR");
+    std::string result = (dir && *dir) ? dir : "/tmp";
+    if (result.back() != '/') result += '/';
+    return result;
+#endif
+}
+
+bool copy_file(const std::string& from, const std::string& to) {
+    FILE* in = std::fopen(from.c_str(), "rb");
+    if (!in) return false;
+    FILE* out = std::fopen(to.c_str(), "wb");
+    if (!out) {
+        std::fclose(in);
+        return false;
+    }
+
+    char buffer[1 << 16];
+    size_t n;
+    bool ok = true;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        if (std::fwrite(buffer, 1, n, out) != n) {
+            ok = false;
+            break;
+        }
+    }
+
+    std::fclose(in);
+    ok = (std::fclose(out) == 0) && ok;
+    if (!ok) std::remove(to.c_str());
+    return ok;
+}
+
+void* load_library(const std::string& path, std::string& error) {
+#if defined(_WIN32)
+    HMODULE handle = LoadLibraryA(path.c_str());
+    if (!handle) error = "LoadLibrary failed with error " + std::to_string(GetLastError());
+    return reinterpret_cast<void*>(handle);
+#else
+    void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) error = dlerror();
+    return handle;
+#endif
+}
+
+void* find_symbol(void* handle, const char* name) {
+#if defined(_WIN32)
+    return reinterpret_cast<void*>(GetProcAddress(reinterpret_cast<HMODULE>(handle), name));
+#else
+    return dlsym(handle, name);
+#endif
+}
+
+void close_library(void* handle) {
+#if defined(_WIN32)
+    FreeLibrary(reinterpret_cast<HMODULE>(handle));
+#else
+    dlclose(handle);
+#endif
+}
+
+int process_id() {
+#if defined(_WIN32)
+    return _getpid();
+#else
+    return static_cast<int>(getpid());
+#endif
+}
+
+} // namespace
+
+std::shared_ptr<CoreLibrary> CoreLibrary::open() {
+    const std::string installed = module_directory() + "/" + SUPERPY_CORE_LIBRARY;
+    std::string error;
+
+    {
+        std::lock_guard<std::mutex> lock(loader_mutex);
+        if (!in_place_loaded) {
+            void* handle = load_library(installed, error);
+            if (!handle) {
+                throw std::runtime_error("Failed to load SuperPy core library " + installed + ": " + error);
+            }
+            auto create = reinterpret_cast<superpy_create_core_fn>(find_symbol(handle, "superpy_create_core"));
+            if (!create) {
+                close_library(handle);
+                throw std::runtime_error("SuperPy core library does not export superpy_create_core");
+            }
+            in_place_loaded = true;
+            return std::shared_ptr<CoreLibrary>(new CoreLibrary(handle, create, true, ""));
+        }
+    }
+
+    // The installed file is already mapped: load a private duplicate.
+    std::string copy = temp_directory() + "superpy_snes9x-" +
+                       std::to_string(process_id()) + "-" +
+                       std::to_string(copy_counter++) + "-" + SUPERPY_CORE_LIBRARY;
+    if (!copy_file(installed, copy)) {
+        throw std::runtime_error("Failed to create private copy of SuperPy core library at " + copy);
+    }
+
+    void* handle = load_library(copy, error);
+    if (!handle) {
+        std::remove(copy.c_str());
+        throw std::runtime_error("Failed to load SuperPy core library " + copy + ": " + error);
+    }
+
+#if defined(_WIN32)
+    // Windows cannot delete a loaded DLL; remove it once released.
+    std::string remove_on_close = copy;
+#else
+    // The mapping stays valid after unlinking, so nothing is left behind
+    // even if the process is killed.
+    std::remove(copy.c_str());
+    std::string remove_on_close;
+#endif
+
+    auto create = reinterpret_cast<superpy_create_core_fn>(find_symbol(handle, "superpy_create_core"));
+    if (!create) {
+        close_library(handle);
+        if (!remove_on_close.empty()) std::remove(remove_on_close.c_str());
+        throw std::runtime_error("SuperPy core library does not export superpy_create_core");
+    }
+    return std::shared_ptr<CoreLibrary>(new CoreLibrary(handle, create, false, remove_on_close));
+}
+
+CoreLibrary::CoreLibrary(void* handle, superpy_create_core_fn create, bool in_place,
+                         std::string remove_on_close)
+    : handle_(handle), create_(create), in_place_(in_place),
+      remove_on_close_(std::move(remove_on_close)) {}
+
+CoreLibrary::~CoreLibrary() {
+    close_library(handle_);
+
+    if (in_place_) {
+        std::lock_guard<std::mutex> lock(loader_mutex);
+        in_place_loaded = false;
+    }
+    if (!remove_on_close_.empty()) {
+        std::remove(remove_on_close_.c_str());
+    }
+}
+
+std::unique_ptr<EmulatorCore> CoreLibrary::create_core() {
+    return std::unique_ptr<EmulatorCore>(create_());
+}
+
+} // namespace superpy
@@ -0,0 +1,44 @@
+/**
+ * SuperPy Core Loader
+ *
+ * Loads private copies of the superpy_snes9x core library so that every
+ * engine owns a complete, independent set of Snes9x globals.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "emulator_core.h"
+
+namespace superpy {
+
+class CoreLibrary {
+public:
+    // Load a fresh copy of the core library. The first copy in the process
+    // is loaded in place; later copies are loaded from a temporary duplicate
+    // of the library file, because the dynamic loader only maps a given
+    // file once. Throws std::runtime_error on failure.
+    static std::shared_ptr<CoreLibrary> open();
+
+    ~CoreLibrary();
+
+    CoreLibrary(const CoreLibrary&) = delete;
+    CoreLibrary& operator=(const CoreLibrary&) = delete;
+
+    // Create the emulator instance living inside this copy.
+    // The returned core must be destroyed before the library is released.
+    std::unique_ptr<EmulatorCore> create_core();
+
+private:
+    CoreLibrary(void* handle, superpy_create_core_fn create, bool in_place,
+                std::string remove_on_close);
+
+    void* handle_;
+    superpy_create_core_fn create_;
+    bool in_place_;                 // loaded from the installed file itself
+    std::string remove_on_close_;   // duplicate to delete once released (Windows)
+};
+
+} // namespace superpy
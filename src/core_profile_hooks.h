@@ -0,0 +1,23 @@
+/**
+ * SuperPy Core Profile Hooks
+ *
+ * Force-included (and only) into the Snes9x sources that drive the other
+ * subsystems: cpuexec.cpp and ppu.cpp. Their calls into rendering, the APU,
+ * DMA and the coprocessors are renamed to timed wrappers defined in
+ * snes9x_core.cpp, which call straight through while the profiler is off.
+ * The renaming also covers the declarations these files see, so the
+ * wrappers keep the original signatures; the defining files are untouched.
+ */
+
+#pragma once
+
+#define S9xUpdateScreen       superpy_profiled_S9xUpdateScreen
+#define S9xEndScreenRefresh   superpy_profiled_S9xEndScreenRefresh
+#define S9xAPUEndScanline     superpy_profiled_S9xAPUEndScanline
+#define S9xAPUReadPort        superpy_profiled_S9xAPUReadPort
+#define S9xAPUWritePort       superpy_profiled_S9xAPUWritePort
+#define S9xDoDMA              superpy_profiled_S9xDoDMA
+#define S9xDoHDMA             superpy_profiled_S9xDoHDMA
+#define S9xStartHDMA          superpy_profiled_S9xStartHDMA
+#define S9xSA1MainLoop        superpy_profiled_S9xSA1MainLoop
+#define S9xSuperFXExec        superpy_profiled_S9xSuperFXExec
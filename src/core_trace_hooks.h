@@ -0,0 +1,48 @@
+/**
+ * SuperPy Core Trace Hooks
+ *
+ * Force-included (and only) into Snes9x's cpuops.cpp, the 65816 opcodes.
+ * Their bus accesses are renamed to wrappers that call the real getset.h
+ * accessors and, while a trace is active, report the access to the tracer
+ * in snes9x_core.cpp (see EmulatorCore::set_trace). getset.h is included
+ * first so its own definitions keep their names; sa1cpu.cpp, which builds
+ * the SA-1 from the same opcodes with its own accessors, is untouched.
+ */
+
+#pragma once
+
+#include "snes9x.h"
+#include "memmap.h"
+#include "getset.h"
+
+// Set by the core while a trace is active
+extern bool superpy_trace_active;
+void superpy_trace_access(uint32 address, uint32 value, int size, bool write);
+
+inline uint8 superpy_traced_S9xGetByte(uint32 Address) {
+    uint8 value = S9xGetByte(Address);
+    if (superpy_trace_active) superpy_trace_access(Address, value, 1, false);
+    return value;
+}
+
+inline uint16 superpy_traced_S9xGetWord(uint32 Address, enum s9xwrap_t w = WRAP_NONE) {
+    uint16 value = S9xGetWord(Address, w);
+    if (superpy_trace_active) superpy_trace_access(Address, value, 2, false);
+    return value;
+}
+
+inline void superpy_traced_S9xSetByte(uint8 Byte, uint32 Address) {
+    if (superpy_trace_active) superpy_trace_access(Address, Byte, 1, true);
+    S9xSetByte(Byte, Address);
+}
+
+inline void superpy_traced_S9xSetWord(uint16 Word, uint32 Address, enum s9xwrap_t w = WRAP_NONE,
+                                      enum s9xwriteorder_t o = WRITE_01) {
+    if (superpy_trace_active) superpy_trace_access(Address, Word, 2, true);
+    S9xSetWord(Word, Address, w, o);
+}
+
+#define S9xGetByte  superpy_traced_S9xGetByte
+#define S9xGetWord  superpy_traced_S9xGetWord
+#define S9xSetByte  superpy_traced_S9xSetByte
+#define S9xSetWord  superpy_traced_S9xSetWord
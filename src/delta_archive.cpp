@@ -0,0 +1,177 @@
+/**
+ * SuperPy Delta Archive
+ *
+ * Nearby frames differ in a few KB of WRAM/VRAM/registers out of several
+ * hundred KB of snapshot, so XOR against the parent is almost all zeros.
+ * The encoder skips equal bytes eight at a time and only breaks a literal
+ * run at eight or more equal bytes, where a new [skip][length] header
+ * becomes cheaper than carrying the zeros.
+ */
+
+#include "delta_archive.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace superpy {
+
+// Equal bytes needed to end a literal run
+static constexpr size_t MIN_SKIP = 8;
+
+static inline uint64_t load64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static void put_varint(std::vector<uint8_t>& out, size_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static size_t get_varint(const uint8_t*& p) {
+    size_t value = 0;
+    int shift = 0;
+    while (*p & 0x80) {
+        value |= static_cast<size_t>(*p++ & 0x7F) << shift;
+        shift += 7;
+    }
+    value |= static_cast<size_t>(*p++) << shift;
+    return value;
+}
+
+void encode_delta(const uint8_t* base, const uint8_t* state, size_t size, std::vector<uint8_t>& out) {
+    auto base_at = [base](size_t i) -> uint8_t { return base ? base[i] : 0; };
+    auto base64_at = [base](size_t i) -> uint64_t { return base ? load64(base + i) : 0; };
+
+    size_t pos = 0;  // end of the previous literal run
+    size_t i = 0;
+    while (i < size) {
+        // Skip unchanged bytes, a word at a time
+        while (i + 8 <= size && base64_at(i) == load64(state + i)) i += 8;
+        while (i < size && base_at(i) == state[i]) i++;
+        if (i == size) break;
+
+        // Literal run up to the next MIN_SKIP equal bytes
+        size_t start = i;
+        size_t end = i;
+        size_t equal = 0;
+        for (; i < size && equal < MIN_SKIP; i++) {
+            if (base_at(i) == state[i]) {
+                equal++;
+            } else {
+                equal = 0;
+                end = i + 1;
+            }
+        }
+
+        put_varint(out, start - pos);
+        put_varint(out, end - start);
+        for (size_t k = start; k < end; k++) {
+            out.push_back(base_at(k) ^ state[k]);
+        }
+        pos = end;
+        i = end;
+    }
+}
+
+void apply_delta(const uint8_t* delta, size_t delta_size, uint8_t* state) {
+    const uint8_t* p = delta;
+    const uint8_t* end = delta + delta_size;
+    uint8_t* dst = state;
+
+    while (p < end) {
+        dst += get_varint(p);
+        size_t length = get_varint(p);
+        for (size_t k = 0; k < length; k++) {
+            dst[k] ^= p[k];
+        }
+        dst += length;
+        p += length;
+    }
+}
+
+DeltaArchive::DeltaArchive(SuperPyEngine& engine, int keyframe_interval)
+    : engine_(engine), keyframe_interval_(keyframe_interval),
+      state_size_(engine.state_size()), memory_bytes_(0), cache_id_(-1) {
+    if (keyframe_interval <= 0) {
+        throw std::invalid_argument("keyframe_interval must be positive");
+    }
+    if (state_size_ == 0) {
+        throw std::invalid_argument("engine has no ROM loaded");
+    }
+
+    cache_.resize(state_size_);
+    scratch_.resize(state_size_);
+}
+
+size_t DeltaArchive::check(int id) const {
+    if (id < 0 || id >= size()) {
+        throw std::out_of_range("snapshot " + std::to_string(id) + " out of range for archive of " +
+                                std::to_string(size()));
+    }
+    return static_cast<size_t>(id);
+}
+
+void DeltaArchive::reconstruct(int id) {
+    if (id == cache_id_) return;
+
+    // Walk up to the keyframe, or to the cached snapshot if it is an ancestor
+    chain_.clear();
+    int node = id;
+    while (node != cache_id_) {
+        chain_.push_back(node);
+        if (entries_[node].parent < 0) break;
+        node = entries_[node].parent;
+    }
+
+    // Keyframes are deltas against zeros
+    if (node != cache_id_) {
+        std::memset(cache_.data(), 0, state_size_);
+    }
+    for (auto it = chain_.rbegin(); it != chain_.rend(); ++it) {
+        const Entry& entry = entries_[*it];
+        apply_delta(entry.data.data(), entry.data.size(), cache_.data());
+    }
+    cache_id_ = id;
+}
+
+int DeltaArchive::save(int parent) {
+    if (parent >= 0) check(parent);
+    if (engine_.state_size() != state_size_ || !engine_.save_state_into(scratch_.data(), state_size_)) {
+        return -1;
+    }
+
+    Entry entry;
+    entry.parent = -1;
+    entry.depth = 0;
+    if (parent >= 0 && entries_[parent].depth + 1 < keyframe_interval_) {
+        reconstruct(parent);
+        entry.parent = parent;
+        entry.depth = entries_[parent].depth + 1;
+        encode_delta(cache_.data(), scratch_.data(), state_size_, entry.data);
+    } else {
+        encode_delta(nullptr, scratch_.data(), state_size_, entry.data);
+    }
+    entry.data.shrink_to_fit();
+
+    memory_bytes_ += entry.data.size();
+    entries_.push_back(std::move(entry));
+
+    // The new snapshot is now the one most likely to be extended
+    cache_.swap(scratch_);
+    cache_id_ = size() - 1;
+    return cache_id_;
+}
+
+bool DeltaArchive::restore(int id) {
+    check(id);
+    reconstruct(id);
+    return engine_.load_state(cache_.data(), state_size_);
+}
+
+} // namespace superpy
@@ -0,0 +1,83 @@
+/**
+ * SuperPy Delta Archive
+ * Snapshots stored as XOR/RLE deltas against a parent snapshot
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "snes9x_adapter.h"
+
+namespace superpy {
+
+// Append the delta turning `base` into `state` (both `size` bytes) to out.
+// A null base means all zeros, which turns the delta into plain zero-run
+// compression. Format: repeated [varint skip][varint length][length XOR bytes].
+void encode_delta(const uint8_t* base, const uint8_t* state, size_t size, std::vector<uint8_t>& out);
+
+// XOR a delta produced by encode_delta() into state, in place
+void apply_delta(const uint8_t* delta, size_t delta_size, uint8_t* state);
+
+// Archive of engine snapshots for exploration workloads that keep very many
+// nearby states. Each snapshot is a delta against its parent; every
+// keyframe_interval-th link of a chain is stored as a keyframe instead, so
+// restoring never applies more than keyframe_interval deltas. Snapshot ids
+// are dense and stable. The archive belongs to one engine and must not
+// outlive it.
+class DeltaArchive {
+public:
+    // Throws std::invalid_argument if keyframe_interval <= 0 or the engine
+    // has no ROM loaded
+    explicit DeltaArchive(SuperPyEngine& engine, int keyframe_interval = 32);
+
+    // Snapshot the engine, as a delta against `parent` (an existing id) or
+    // as a keyframe if parent is -1. Returns the new id, or -1 if the
+    // engine's state could not be saved. Throws std::out_of_range for
+    // unknown parents.
+    int save(int parent = -1);
+
+    // Reconstruct a snapshot and load it into the engine
+    bool restore(int id);
+
+    int size() const { return static_cast<int>(entries_.size()); }
+    int keyframe_interval() const { return keyframe_interval_; }
+    size_t state_size() const { return state_size_; }
+    SuperPyEngine& engine() { return engine_; }
+
+    int parent(int id) const { return entries_[check(id)].parent; }
+    bool is_keyframe(int id) const { return entries_[check(id)].parent < 0; }
+
+    // Stored bytes of one snapshot and of the whole archive
+    size_t snapshot_bytes(int id) const { return entries_[check(id)].data.size(); }
+    size_t memory_bytes() const { return memory_bytes_; }
+
+private:
+    struct Entry {
+        int parent;     // -1 for keyframes
+        int depth;      // deltas between this entry and its keyframe
+        std::vector<uint8_t> data;
+    };
+
+    size_t check(int id) const;
+    // Make cache_ hold snapshot `id`
+    void reconstruct(int id);
+
+    SuperPyEngine& engine_;
+    int keyframe_interval_;
+    size_t state_size_;
+    std::vector<Entry> entries_;
+    size_t memory_bytes_;
+
+    // Most recently saved or restored snapshot, in full. Saving children of
+    // the snapshot just restored (the usual exploration pattern) starts
+    // from here instead of walking the chain.
+    int cache_id_;
+    std::vector<uint8_t> cache_;
+    std::vector<uint8_t> scratch_;
+    std::vector<int> chain_;
+};
+
+} // namespace superpy
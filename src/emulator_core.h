@@ -0,0 +1,140 @@
+/**
+ * SuperPy Emulator Core Interface
+ *
+ * Snes9x keeps its whole machine state in process-global singletons
+ * (Settings, Memory, CPU, PPU, IPPU, GFX, the APU...). To run several
+ * independent emulators in one process, the Snes9x sources are built into a
+ * separate shared library and every SuperPyEngine loads its own private copy
+ * of it (see core_loader.h). Each copy has its own set of globals.
+ *
+ * This header is the only thing shared between the Python module and the
+ * core library: an abstract interface whose vtable lives in the loaded copy,
+ * so every call is executed against that copy's globals.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_WIN32)
+#define SUPERPY_CORE_EXPORT __declspec(dllexport)
+#else
+#define SUPERPY_CORE_EXPORT __attribute__((visibility("default")))
+#endif
+
+namespace superpy {
+
+// Layout of a shared ROM image (see EmulatorCore::share_rom), matching
+// Snes9x's own ROM buffer: the ROM starts SHARED_ROM_GUARD bytes into a
+// zero-filled region of SHARED_ROM_GUARD + SHARED_ROM_CAPACITY bytes.
+static constexpr size_t SHARED_ROM_GUARD = 0x8000;
+static constexpr size_t SHARED_ROM_CAPACITY = 0x800000 + 0x200;
+
+// Subsystems timed by the core's frame profiler
+enum ProfileSubsystem : int {
+    PROFILE_CPU,        // 65816 core and everything not listed below
+    PROFILE_PPU,        // tile/line rendering and frame end (S9xUpdateScreen...)
+    PROFILE_APU,        // SPC700/DSP catch-up
+    PROFILE_DMA,        // general DMA and HDMA
+    PROFILE_SA1,
+    PROFILE_SUPERFX,
+    PROFILE_CORE_COUNT,
+};
+
+// Memory access trace (see EmulatorCore::set_trace)
+enum TraceFlags : uint8_t {
+    TRACE_READ = 1,
+    TRACE_WRITE = 2,
+};
+
+struct MemoryAccess {
+    uint32_t address;   // WRAM offset of the (first) byte
+    uint32_t pc;        // 65816 bank:PC during the access, past the operand bytes fetched so far
+    uint32_t frame;     // as last passed to set_trace_frame()
+    uint16_t value;     // byte, or word for 16-bit accesses
+    uint16_t scanline;
+    uint8_t flags;      // TRACE_READ or TRACE_WRITE
+    uint8_t size;       // 1 or 2 bytes
+};
+
+class EmulatorCore {
+public:
+    virtual ~EmulatorCore() = default;
+
+    // ROM management
+    virtual bool load_rom(const char* path) = 0;
+    virtual void reset() = 0;
+
+    // Emulation
+    virtual void set_joypad(int port, uint32_t mask) = 0;
+    virtual void run_frame(bool render) = 0;
+
+    // No-video mode: run_frame() never renders, whatever `render` says.
+    // PPU registers, VRAM/OAM and sprite range/time-over flags are still
+    // emulated, only tile/line rendering and framebuffer writes are skipped.
+    virtual void set_video(bool enabled) = 0;
+
+    // Native RGB565 framebuffer of the last rendered frame.
+    // pitch is in pixels, width/height are the rendered dimensions.
+    virtual const uint16_t* screen() const = 0;
+    virtual int screen_pitch() const = 0;
+    virtual int screen_width() const = 0;
+    virtual int screen_height() const = 0;
+
+    // Memory access (128KB SNES RAM)
+    virtual uint8_t* ram() = 0;
+
+    // The loaded ROM as emulated (after header removal, deinterleaving...)
+    virtual const uint8_t* rom_data() const = 0;
+    virtual size_t rom_size() const = 0;
+
+    // Read the ROM from `rom` instead of the private copy, which is then
+    // released. rom must hold the same bytes as rom_data(), sit inside a
+    // region laid out as above, and outlive the core. Returns false (and
+    // keeps the private copy) for cartridges whose coprocessor caches ROM
+    // pointers of its own.
+    virtual bool share_rom(const uint8_t* rom) = 0;
+
+    // State management
+    virtual size_t state_size() = 0;
+    virtual bool freeze(uint8_t* dst, size_t size) = 0;
+    virtual bool unfreeze(const uint8_t* src, size_t size) = 0;
+
+    // Rewind ring (Snes9x StateManager): delta-compressed snapshots in a
+    // fixed buffer of buffer_bytes, oldest overwritten first. 0 disables it.
+    virtual bool rewind_init(size_t buffer_bytes) = 0;
+    virtual bool rewind_push() = 0;
+    // Restore the newest snapshot not restored yet: the first pop after a
+    // push restores that push, every further pop the one before it
+    virtual bool rewind_pop() = 0;
+
+    // Frame profiler: while enabled, run_frame() splits its wall time
+    // between the subsystems above (see core_profile_hooks.h); profile()
+    // returns the split of the last frame in nanoseconds
+    virtual void set_profiling(bool enabled) = 0;
+    virtual void profile(uint64_t ns[PROFILE_CORE_COUNT]) const = 0;
+
+    // Memory access trace: 65816 instruction reads/writes of WRAM bytes
+    // whose entry in `watch` (128KB of TraceFlags, copied) has the access's
+    // flag are recorded into a preallocated ring of `capacity` events,
+    // oldest overwritten first (see core_trace_hooks.h). A null watch turns
+    // tracing off; while off, every access costs one branch. SA-1 and DMA
+    // accesses are not traced.
+    virtual void set_trace(const uint8_t* watch, size_t capacity) = 0;
+    virtual void set_trace_frame(uint32_t frame) = 0;
+    // Move up to max of the oldest events into dst; returns the count
+    virtual size_t trace_take(MemoryAccess* dst, size_t max) = 0;
+    // Events recorded and not taken yet
+    virtual size_t trace_pending() const = 0;
+    // Events overwritten before they were taken
+    virtual uint64_t trace_lost() const = 0;
+};
+
+} // namespace superpy
+
+// Entry point exported by the core library
+extern "C" {
+typedef superpy::EmulatorCore* (*superpy_create_core_fn)();
+SUPERPY_CORE_EXPORT superpy::EmulatorCore* superpy_create_core();
+}
@@ -0,0 +1,243 @@
+/**
+ * SuperPy Fork Server
+ *
+ * Each worker has a channel in the shared mapping: the parent fills in a
+ * command and bumps `request`, the worker runs it, writes its results
+ * straight into the shared buffers and publishes `response = request`.
+ * Both sides wait with wait_change() (process_sync.h), whose periodic
+ * timeouts let the parent notice dead workers and workers a dead parent.
+ *
+ * The mapping outlives close() so result views handed out earlier stay
+ * valid; it is released by the destructor.
+ */
+
+#include "fork_server.h"
+#include "process_sync.h"
+
+#include <atomic>
+#include <cerrno>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#if !defined(_WIN32)
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace superpy {
+
+enum Command : uint32_t {
+    CMD_STEP,
+    CMD_RESET,
+    CMD_STOP,
+};
+
+struct alignas(64) ForkServer::Channel {
+    std::atomic<uint32_t> request{0};
+    std::atomic<uint32_t> response{0};
+    uint32_t command = CMD_STEP;
+    uint32_t action = 0;
+    int32_t frames = 1;
+    uint32_t max_pool = 0;
+};
+
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+#if !defined(_WIN32)
+
+// Body of a worker process; never returns
+[[noreturn]] static void worker_main(SuperPyEngine& engine, ForkServer::Channel& channel, uint8_t* observation,
+                                     float* reward, bool* done, pid_t parent) {
+    // Ctrl-C is the parent's to handle; it stops the workers itself.
+    // (No PR_SET_PDEATHSIG: it fires when the forking *thread* exits.)
+    signal(SIGINT, SIG_IGN);
+    if (getppid() != parent) _exit(0);
+
+    // Rewards count from the fork on
+    engine.take_reward();
+
+    // The parent may have posted a request before this process got to run
+    uint32_t seen = channel.response.load(std::memory_order_acquire);
+    for (;;) {
+        if (!wait_change(channel.request, seen)) {
+            if (getppid() != parent) _exit(0);
+            continue;
+        }
+        seen = channel.request.load(std::memory_order_acquire);
+
+        if (channel.command == CMD_STEP) {
+            engine.step_skip(channel.action, channel.frames, channel.max_pool != 0, observation);
+        } else if (channel.command == CMD_RESET) {
+            engine.reset();
+            engine.observe(observation);
+        }
+        *reward = engine.take_reward();
+        *done = engine.is_done();
+
+        channel.response.store(seen, std::memory_order_release);
+        wake_all(channel.response);
+        if (channel.command == CMD_STOP) _exit(0);
+    }
+}
+
+#endif // !_WIN32
+
+ForkServer::ForkServer(SuperPyEngine& engine, int num_workers)
+    : closed_(true), element_size_(0), observation_bytes_(0), shared_(nullptr), shared_size_(0),
+      channels_(nullptr), observations_(nullptr), rewards_(nullptr), dones_(nullptr) {
+    if (num_workers <= 0) {
+        throw std::invalid_argument("num_workers must be positive");
+    }
+    if (engine.state_size() == 0) {
+        throw std::invalid_argument("engine has no ROM loaded");
+    }
+
+#if defined(_WIN32)
+    throw std::runtime_error("ForkServer requires fork(), which is not available on Windows");
+#else
+    const ObservationPipeline& pipeline = engine.observation();
+    pipeline.shape(shape_);
+    element_size_ = pipeline.element_size();
+    observation_bytes_ = pipeline.size_bytes();
+
+    size_t n = static_cast<size_t>(num_workers);
+    size_t observations_offset = align_up(n * sizeof(Channel), 64);
+    size_t rewards_offset = align_up(observations_offset + n * observation_bytes_, 64);
+    size_t dones_offset = rewards_offset + n * sizeof(float);
+    shared_size_ = dones_offset + n * sizeof(bool);
+
+    shared_ = mmap(nullptr, shared_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared_ == MAP_FAILED) {
+        shared_ = nullptr;
+        throw std::runtime_error("failed to map shared memory for fork server");
+    }
+
+    uint8_t* base = static_cast<uint8_t*>(shared_);
+    channels_ = reinterpret_cast<Channel*>(base);
+    for (size_t i = 0; i < n; i++) {
+        new (&channels_[i]) Channel();
+    }
+    observations_ = base + observations_offset;
+    rewards_ = reinterpret_cast<float*>(base + rewards_offset);
+    dones_ = reinterpret_cast<bool*>(base + dones_offset);
+
+    // Every worker starts from the parent's current frame
+    for (size_t i = 0; i < n; i++) {
+        engine.observe(observations_ + i * observation_bytes_);
+        dones_[i] = engine.is_done();
+    }
+
+    closed_ = false;
+    pid_t parent = getpid();
+    pids_.reserve(n);
+    for (int i = 0; i < num_workers; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            worker_main(engine, channels_[i], observations_ + i * observation_bytes_, &rewards_[i], &dones_[i],
+                        parent);
+        }
+        if (pid < 0) {
+            close();
+            munmap(shared_, shared_size_);
+            throw std::runtime_error("fork failed after " + std::to_string(i) + " workers");
+        }
+        pids_.push_back(pid);
+    }
+#endif
+}
+
+ForkServer::~ForkServer() {
+    close();
+#if !defined(_WIN32)
+    if (shared_) munmap(shared_, shared_size_);
+#endif
+}
+
+void ForkServer::observation_shape(size_t out[3]) const {
+    out[0] = shape_[0];
+    out[1] = shape_[1];
+    out[2] = shape_[2];
+}
+
+void ForkServer::step(const uint32_t* actions, int frames, bool max_pool) {
+    for (int i = 0; i < num_workers(); i++) {
+        send(i, CMD_STEP, actions[i], frames, max_pool);
+    }
+    wait_all();
+}
+
+void ForkServer::reset() {
+    for (int i = 0; i < num_workers(); i++) {
+        send(i, CMD_RESET, 0, 0, false);
+    }
+    wait_all();
+}
+
+void ForkServer::send(int worker, uint32_t command, uint32_t action, int frames, bool max_pool) {
+#if defined(_WIN32)
+    (void)worker; (void)command; (void)action; (void)frames; (void)max_pool;
+#else
+    if (closed_) {
+        throw std::runtime_error("fork server is closed");
+    }
+
+    Channel& channel = channels_[worker];
+    channel.command = command;
+    channel.action = action;
+    channel.frames = frames;
+    channel.max_pool = max_pool ? 1 : 0;
+
+    // Release publishes the command fields along with the new request
+    channel.request.store(channel.request.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    wake_all(channel.request);
+#endif
+}
+
+void ForkServer::wait_all() {
+#if !defined(_WIN32)
+    for (int i = 0; i < num_workers(); i++) {
+        Channel& channel = channels_[i];
+        uint32_t request = channel.request.load(std::memory_order_relaxed);
+        for (;;) {
+            uint32_t response = channel.response.load(std::memory_order_acquire);
+            if (response == request) break;
+            if (wait_change(channel.response, response)) continue;
+
+            int status;
+            if (waitpid(pids_[i], &status, WNOHANG) == pids_[i]) {
+                pids_[i] = -1;
+                close();
+                throw std::runtime_error("fork server worker " + std::to_string(i) + " exited");
+            }
+        }
+    }
+#endif
+}
+
+void ForkServer::close() {
+#if !defined(_WIN32)
+    if (closed_) return;
+    closed_ = true;
+
+    for (size_t i = 0; i < pids_.size(); i++) {
+        if (pids_[i] <= 0) continue;
+        Channel& channel = channels_[i];
+        channel.command = CMD_STOP;
+        channel.request.store(channel.request.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        wake_all(channel.request);
+    }
+    for (int pid : pids_) {
+        if (pid <= 0) continue;
+        int status;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+        }
+    }
+#endif
+}
+
+} // namespace superpy
@@ -0,0 +1,82 @@
+/**
+ * SuperPy Fork Server
+ * Pre-warmed emulator worker processes forked from one loaded engine
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "snes9x_adapter.h"
+
+namespace superpy {
+
+// Forks num_workers processes from the calling one. Each child inherits the
+// engine exactly as it is (ROM loaded, intro played, observation spec set)
+// copy-on-write, so starting a worker costs a fork instead of a Python
+// import, a ROM load and an intro. Children only run native stepping code
+// and never return to Python; commands and results travel through a shared
+// memory channel per worker, and all observations land in one contiguous
+// shared buffer like VectorEngine's. POSIX only.
+class ForkServer {
+public:
+    // Throws std::invalid_argument if num_workers <= 0 or the engine has no
+    // ROM, std::runtime_error if the shared memory or a fork fails (or on
+    // platforms without fork)
+    ForkServer(SuperPyEngine& engine, int num_workers);
+    ~ForkServer();
+
+    ForkServer(const ForkServer&) = delete;
+    ForkServer& operator=(const ForkServer&) = delete;
+
+    // Same semantics as VectorEngine::step/reset, each worker in its own
+    // process. Throw std::runtime_error if a worker process died.
+    void step(const uint32_t* actions, int frames = 1, bool max_pool = false);
+    void reset();
+
+    // Stop and reap all workers; called by the destructor. The result
+    // buffers stay readable until the server is destroyed.
+    void close();
+
+    int num_workers() const { return static_cast<int>(pids_.size()); }
+    bool closed() const { return closed_; }
+
+    // Per-worker observation shape and element size (engine's observation spec)
+    void observation_shape(size_t out[3]) const;
+    size_t observation_element_size() const { return element_size_; }
+
+    // Shared result buffers, overwritten by every step()/reset()
+    uint8_t* observations() { return observations_; }
+    float* rewards() { return rewards_; }
+    bool* dones() { return dones_; }
+
+    std::mutex& call_mutex() { return call_mutex_; }
+
+    // Per-worker command slot in the shared mapping (fork_server.cpp)
+    struct Channel;
+
+private:
+    void send(int worker, uint32_t command, uint32_t action, int frames, bool max_pool);
+    void wait_all();
+
+    std::mutex call_mutex_;
+    std::vector<int> pids_;
+    bool closed_;
+
+    size_t shape_[3];
+    size_t element_size_;
+    size_t observation_bytes_;
+
+    // One shared mapping: channels | observations | rewards | dones
+    void* shared_;
+    size_t shared_size_;
+    Channel* channels_;
+    uint8_t* observations_;
+    float* rewards_;
+    bool* dones_;
+};
+
+} // namespace superpy
@@ -0,0 +1,72 @@
+/**
+ * SuperPy Frame Profiler
+ */
+
+#include "frame_profiler.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace superpy {
+
+const char* const FrameProfiler::NAMES[PROFILE_COUNT] = {
+    "cpu", "ppu", "apu", "dma", "sa1", "superfx", "screen"
+};
+
+void FrameProfiler::begin_frame(const uint64_t core_ns[PROFILE_CORE_COUNT]) {
+    commit();
+    memcpy(frame_, core_ns, sizeof(uint64_t) * PROFILE_CORE_COUNT);
+    frame_[PROFILE_SCREEN] = 0;
+    pending_ = true;
+}
+
+void FrameProfiler::commit() {
+    if (!pending_) return;
+    if (samples_.empty()) samples_.resize(WINDOW * PROFILE_COUNT);
+    memcpy(&samples_[(frames_ % WINDOW) * PROFILE_COUNT], frame_, sizeof(frame_));
+    frames_++;
+    pending_ = false;
+}
+
+void FrameProfiler::clear() {
+    pending_ = false;
+    frames_ = 0;
+}
+
+// Nearest-rank percentile of values[0, n), reordering them
+static double percentile_us(uint64_t* values, size_t n, double p) {
+    size_t rank = static_cast<size_t>(p * (n - 1) + 0.5);
+    std::nth_element(values, values + rank, values + n);
+    return values[rank] / 1000.0;
+}
+
+size_t FrameProfiler::stats(Stats out[PROFILE_COUNT + 1]) {
+    commit();
+    size_t n = static_cast<size_t>(std::min<uint64_t>(frames_, WINDOW));
+    if (n == 0) {
+        memset(out, 0, sizeof(Stats) * (PROFILE_COUNT + 1));
+        return 0;
+    }
+
+    scratch_.resize(n);
+    for (int s = 0; s <= PROFILE_COUNT; s++) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            const uint64_t* frame = &samples_[i * PROFILE_COUNT];
+            uint64_t ns = 0;
+            if (s < PROFILE_COUNT) {
+                ns = frame[s];
+            } else {
+                for (int k = 0; k < PROFILE_COUNT; k++) ns += frame[k];
+            }
+            scratch_[i] = ns;
+            sum += ns;
+        }
+        out[s].mean_us = sum / 1000.0 / n;
+        out[s].p50_us = percentile_us(scratch_.data(), n, 0.50);
+        out[s].p99_us = percentile_us(scratch_.data(), n, 0.99);
+    }
+    return n;
+}
+
+} // namespace superpy
@@ -0,0 +1,66 @@
+/**
+ * SuperPy Frame Profiler
+ * Per-subsystem frame times over a sliding window of recent frames
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "emulator_core.h"
+
+namespace superpy {
+
+// The core's subsystems (see emulator_core.h), then the adapter's own
+// screen conversion (get_screen, copy_screen, observe)
+static constexpr int PROFILE_SCREEN = PROFILE_CORE_COUNT;
+static constexpr int PROFILE_COUNT = PROFILE_CORE_COUNT + 1;
+
+inline uint64_t profile_clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class FrameProfiler {
+public:
+    static const char* const NAMES[PROFILE_COUNT];
+
+    // Frames kept for the statistics; older ones are dropped
+    static constexpr size_t WINDOW = 4096;
+
+    struct Stats {
+        double mean_us;
+        double p50_us;
+        double p99_us;
+    };
+
+    // Start a frame with the core's split of it. Time added afterwards
+    // (screen conversion of that frame) still counts towards it, so a frame
+    // is only committed when the next one starts or on stats().
+    void begin_frame(const uint64_t core_ns[PROFILE_CORE_COUNT]);
+    void add(int subsystem, uint64_t ns) {
+        if (pending_) frame_[subsystem] += ns;
+    }
+
+    // Per subsystem in NAMES order, then the whole frame. Returns the
+    // number of frames the statistics cover (all zero if none).
+    size_t stats(Stats out[PROFILE_COUNT + 1]);
+
+    // Frames profiled since the last clear()
+    uint64_t frames() const { return frames_ + (pending_ ? 1 : 0); }
+    void clear();
+
+private:
+    void commit();
+
+    uint64_t frame_[PROFILE_COUNT] = {};
+    bool pending_ = false;
+    std::vector<uint64_t> samples_;   // WINDOW x PROFILE_COUNT ring
+    uint64_t frames_ = 0;             // committed frames
+    std::vector<uint64_t> scratch_;
+};
+
+} // namespace superpy
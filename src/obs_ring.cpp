@@ -0,0 +1,301 @@
+/**
+ * SuperPy Observation Ring
+ *
+ * Segment layout, every part 64-byte aligned:
+ *   Header | head counter per env (one cache line each) | RAM addresses |
+ *   depth x batch { observations (N x obs) | ram (N x K) | rewards | dones }
+ *
+ * A worker writes slot head % depth of its env and then bumps its head
+ * with release order; the learner reads a batch once every head has moved
+ * past it and bumps the tail when done, which frees the slot again. Both
+ * sides sleep in wait_change() (process_sync.h) when they have to wait.
+ */
+
+#include "obs_ring.h"
+#include "process_sync.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace superpy {
+
+static constexpr uint32_t RING_MAGIC = 0x53505252;  // "SPRR"
+static constexpr size_t LINE = 64;
+
+struct alignas(64) ObservationRing::Header {
+    std::atomic<uint32_t> magic;   // published last by the creator
+    int32_t creator;               // pid that removes the name again
+    uint32_t num_envs;
+    uint32_t depth;
+    uint32_t element_size;
+    uint64_t shape[3];
+    uint64_t ram_count;
+    uint64_t addresses_offset;
+    uint64_t batches_offset;
+    uint64_t batch_stride;
+    uint64_t observations_offset;  // inside a batch, like the ones below
+    uint64_t ram_offset;
+    uint64_t rewards_offset;
+    uint64_t dones_offset;
+    alignas(64) std::atomic<uint32_t> tail;
+};
+
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// POSIX wants one leading slash and no others
+static std::string shm_name(const std::string& name) {
+    if (name.empty() || name.find('/', 1) != std::string::npos || (name[0] == '/' && name.size() == 1)) {
+        throw std::invalid_argument("ring name must be non-empty and contain no '/' after the first character");
+    }
+    return name[0] == '/' ? name : "/" + name;
+}
+
+static std::atomic<uint32_t>& head(ObservationRing::Header* header, int env) {
+    uint8_t* heads = reinterpret_cast<uint8_t*>(header) + align_up(sizeof(ObservationRing::Header), LINE);
+    return *reinterpret_cast<std::atomic<uint32_t>*>(heads + env * LINE);
+}
+
+using Clock = std::chrono::steady_clock;
+
+static Clock::time_point deadline_after(int timeout_ms) {
+    return timeout_ms < 0 ? Clock::time_point::max() : Clock::now() + std::chrono::milliseconds(timeout_ms);
+}
+
+// Wait until word != old; false once the deadline has passed
+static bool wait_for(std::atomic<uint32_t>& word, uint32_t old, Clock::time_point deadline) {
+    for (;;) {
+        int chunk = 100;
+        if (deadline != Clock::time_point::max()) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            if (left <= 0) return word.load(std::memory_order_acquire) != old;
+            chunk = static_cast<int>(std::min<long long>(chunk, left));
+        }
+        if (wait_change(word, old, chunk)) return true;
+    }
+}
+
+ObservationRing::ObservationRing(const std::string& name, int num_envs, int depth, const ObservationSpec& spec,
+                                 const std::vector<uint32_t>& ram_addresses)
+    : name_(shm_name(name)), owner_(true), num_envs_(num_envs), depth_(depth),
+      shared_(nullptr), shared_size_(0), header_(nullptr), ram_addresses_(nullptr), batches_(nullptr) {
+    if (num_envs <= 0) {
+        throw std::invalid_argument("num_envs must be positive");
+    }
+    if (depth <= 0) {
+        throw std::invalid_argument("depth must be positive");
+    }
+    for (uint32_t address : ram_addresses) {
+        if (address >= 0x20000) {
+            throw std::invalid_argument("RAM address " + std::to_string(address) + " outside the 128 KB WRAM");
+        }
+    }
+
+    // Validates the spec
+    ObservationPipeline pipeline(spec);
+    pipeline.shape(shape_);
+    element_size_ = pipeline.element_size();
+    observation_bytes_ = pipeline.size_bytes();
+    ram_count_ = ram_addresses.size();
+
+    size_t n = static_cast<size_t>(num_envs);
+    observations_offset_ = 0;
+    ram_offset_ = align_up(n * observation_bytes_, LINE);
+    rewards_offset_ = align_up(ram_offset_ + n * ram_count_, LINE);
+    dones_offset_ = rewards_offset_ + n * sizeof(float);
+    batch_stride_ = align_up(dones_offset_ + n * sizeof(bool), LINE);
+
+    size_t addresses_offset = align_up(sizeof(Header), LINE) + n * LINE;
+    size_t batches_offset = align_up(addresses_offset + ram_count_ * sizeof(uint32_t), LINE);
+
+#if defined(_WIN32)
+    throw std::runtime_error("ObservationRing requires POSIX shared memory");
+#else
+    map(batches_offset + depth_ * batch_stride_, true);
+
+    // The segment starts zero-filled: all counters at 0
+    header_ = new (shared_) Header();
+    for (int i = 0; i < num_envs; i++) {
+        new (&head(header_, i)) std::atomic<uint32_t>(0);
+    }
+    header_->creator = static_cast<int32_t>(getpid());
+    header_->num_envs = static_cast<uint32_t>(num_envs);
+    header_->depth = static_cast<uint32_t>(depth);
+    header_->element_size = static_cast<uint32_t>(element_size_);
+    for (int i = 0; i < 3; i++) header_->shape[i] = shape_[i];
+    header_->ram_count = ram_count_;
+    header_->addresses_offset = addresses_offset;
+    header_->batches_offset = batches_offset;
+    header_->batch_stride = batch_stride_;
+    header_->observations_offset = observations_offset_;
+    header_->ram_offset = ram_offset_;
+    header_->rewards_offset = rewards_offset_;
+    header_->dones_offset = dones_offset_;
+
+    uint8_t* base = static_cast<uint8_t*>(shared_);
+    std::memcpy(base + addresses_offset, ram_addresses.data(), ram_count_ * sizeof(uint32_t));
+    ram_addresses_ = reinterpret_cast<const uint32_t*>(base + addresses_offset);
+    batches_ = base + batches_offset;
+
+    header_->magic.store(RING_MAGIC, std::memory_order_release);
+#endif
+}
+
+ObservationRing::ObservationRing(const std::string& name)
+    : name_(shm_name(name)), owner_(false), num_envs_(0), depth_(0), element_size_(0), observation_bytes_(0),
+      ram_count_(0), observations_offset_(0), ram_offset_(0), rewards_offset_(0), dones_offset_(0),
+      batch_stride_(0), shared_(nullptr), shared_size_(0), header_(nullptr), ram_addresses_(nullptr),
+      batches_(nullptr) {
+#if defined(_WIN32)
+    throw std::runtime_error("ObservationRing requires POSIX shared memory");
+#else
+    map(0, false);
+
+    header_ = static_cast<Header*>(shared_);
+    if (shared_size_ < sizeof(Header) || header_->magic.load(std::memory_order_acquire) != RING_MAGIC) {
+        munmap(shared_, shared_size_);
+        throw std::runtime_error("shared memory segment " + name_ + " is not an observation ring");
+    }
+
+    num_envs_ = static_cast<int>(header_->num_envs);
+    depth_ = static_cast<int>(header_->depth);
+    element_size_ = header_->element_size;
+    for (int i = 0; i < 3; i++) shape_[i] = header_->shape[i];
+    observation_bytes_ = shape_[0] * shape_[1] * shape_[2] * element_size_;
+    ram_count_ = header_->ram_count;
+    batch_stride_ = header_->batch_stride;
+    observations_offset_ = header_->observations_offset;
+    ram_offset_ = header_->ram_offset;
+    rewards_offset_ = header_->rewards_offset;
+    dones_offset_ = header_->dones_offset;
+
+    uint8_t* base = static_cast<uint8_t*>(shared_);
+    ram_addresses_ = reinterpret_cast<const uint32_t*>(base + header_->addresses_offset);
+    batches_ = base + header_->batches_offset;
+#endif
+}
+
+void ObservationRing::map(size_t size, bool create) {
+#if !defined(_WIN32)
+    int fd = create ? shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600)
+                    : shm_open(name_.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        throw std::runtime_error(std::string(create ? "failed to create" : "failed to open") +
+                                 " shared memory segment " + name_ + ": " + std::strerror(errno));
+    }
+
+    struct stat info;
+    bool ok = create ? ftruncate(fd, static_cast<off_t>(size)) == 0 : fstat(fd, &info) == 0;
+    if (ok && !create) size = static_cast<size_t>(info.st_size);
+    void* region = ok ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+
+    if (region == MAP_FAILED) {
+        if (create) shm_unlink(name_.c_str());
+        throw std::runtime_error("failed to map shared memory segment " + name_);
+    }
+    shared_ = region;
+    shared_size_ = size;
+#else
+    (void)size; (void)create;
+#endif
+}
+
+ObservationRing::~ObservationRing() {
+#if !defined(_WIN32)
+    // Forked children (e.g. multiprocessing workers) inherit the object
+    // but must not remove the name
+    if (owner_ && header_ && header_->creator == static_cast<int32_t>(getpid())) {
+        shm_unlink(name_.c_str());
+    }
+    if (shared_) munmap(shared_, shared_size_);
+#endif
+}
+
+void ObservationRing::observation_shape(size_t out[3]) const {
+    out[0] = shape_[0];
+    out[1] = shape_[1];
+    out[2] = shape_[2];
+}
+
+uint32_t ObservationRing::batch() const {
+    return header_->tail.load(std::memory_order_acquire);
+}
+
+bool ObservationRing::push(int env, SuperPyEngine& engine, float reward, bool done, int timeout_ms) {
+    if (env < 0 || env >= num_envs_) {
+        throw std::out_of_range("env " + std::to_string(env) + " out of range for ring of " +
+                                std::to_string(num_envs_));
+    }
+    if (engine.observation_size() != observation_bytes_) {
+        throw std::invalid_argument("engine observation spec does not match the ring");
+    }
+    const uint8_t* memory = engine.get_memory();
+    if (!memory) {
+        throw std::runtime_error("engine has no ROM loaded");
+    }
+
+    // Only this env's worker moves its head
+    std::atomic<uint32_t>& env_head = head(header_, env);
+    uint32_t position = env_head.load(std::memory_order_relaxed);
+    auto deadline = deadline_after(timeout_ms);
+    for (;;) {
+        uint32_t tail = header_->tail.load(std::memory_order_acquire);
+        if (position - tail < static_cast<uint32_t>(depth_)) break;
+        if (!wait_for(header_->tail, tail, deadline)) return false;
+    }
+
+    uint8_t* batch = slot(position);
+    engine.observe(batch + observations_offset_ + env * observation_bytes_);
+
+    uint8_t* ram = batch + ram_offset_ + env * ram_count_;
+    for (size_t i = 0; i < ram_count_; i++) {
+        ram[i] = memory[ram_addresses_[i]];
+    }
+    reinterpret_cast<float*>(batch + rewards_offset_)[env] = reward;
+    reinterpret_cast<bool*>(batch + dones_offset_)[env] = done;
+
+    env_head.store(position + 1, std::memory_order_release);
+    wake_all(env_head);
+    return true;
+}
+
+bool ObservationRing::wait(int timeout_ms) {
+    uint32_t tail = batch();
+    auto deadline = deadline_after(timeout_ms);
+    for (int i = 0; i < num_envs_; i++) {
+        std::atomic<uint32_t>& env_head = head(header_, i);
+        // Heads never fall behind the tail, so "moved" means "pushed this batch"
+        if (env_head.load(std::memory_order_acquire) == tail && !wait_for(env_head, tail, deadline)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ObservationRing::release() {
+    uint32_t tail = batch();
+    for (int i = 0; i < num_envs_; i++) {
+        if (head(header_, i).load(std::memory_order_acquire) == tail) {
+            throw std::runtime_error("release() called before every env pushed the batch");
+        }
+    }
+    header_->tail.fetch_add(1, std::memory_order_release);
+    wake_all(header_->tail);
+}
+
+} // namespace superpy
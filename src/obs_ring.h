@@ -0,0 +1,114 @@
+/**
+ * SuperPy Observation Ring
+ * Shared-memory transport of step results from worker processes to a learner
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "observation.h"
+#include "snes9x_adapter.h"
+
+namespace superpy {
+
+// A named POSIX shared-memory segment holding `depth` batches of results
+// for num_envs environments: observations, selected RAM bytes, rewards and
+// dones, each batch laid out as contiguous (N, ...) arrays. Worker processes
+// attach by name and push() their engine's results straight into the slot
+// of their env; the learner wait()s for a complete batch, reads it in place
+// and release()s it. Nothing is pickled or copied through a pipe.
+//
+// Each env slot is single-producer/single-consumer: a per-env head counts
+// pushed batches, one shared tail counts released ones, and a worker may
+// run up to `depth` batches ahead of the learner. POSIX only.
+class ObservationRing {
+public:
+    // Create the segment (learner side). Observations follow `spec`; the
+    // bytes at ram_addresses (WRAM offsets) are gathered on every push.
+    // Throws std::invalid_argument for bad sizes or addresses and
+    // std::runtime_error if the segment cannot be created (e.g. it exists).
+    ObservationRing(const std::string& name, int num_envs, int depth, const ObservationSpec& spec,
+                    const std::vector<uint32_t>& ram_addresses);
+
+    // Attach to a segment created by another process (worker side).
+    // Throws std::runtime_error if it does not exist or is not a ring.
+    explicit ObservationRing(const std::string& name);
+
+    // Unmaps; the creating process also removes the name
+    ~ObservationRing();
+
+    ObservationRing(const ObservationRing&) = delete;
+    ObservationRing& operator=(const ObservationRing&) = delete;
+
+    // Worker side: write the engine's current observation, RAM bytes,
+    // reward and done into env's next slot and publish it. Blocks while the
+    // env is `depth` batches ahead of the learner; returns false if that
+    // takes longer than timeout_ms (< 0 waits forever). Throws
+    // std::out_of_range for a bad env, std::invalid_argument if the
+    // engine's observation spec does not match the ring's and
+    // std::runtime_error if it has no ROM loaded.
+    bool push(int env, SuperPyEngine& engine, float reward, bool done, int timeout_ms = -1);
+
+    // Learner side: wait until every env has pushed the current batch;
+    // false on timeout. The batch arrays below are valid until release().
+    bool wait(int timeout_ms = -1);
+    void release();
+
+    // Index of the batch wait() waits for (number of released batches)
+    uint32_t batch() const;
+
+    int num_envs() const { return num_envs_; }
+    int depth() const { return depth_; }
+    const std::string& name() const { return name_; }
+    bool owner() const { return owner_; }
+
+    void observation_shape(size_t out[3]) const;
+    size_t observation_element_size() const { return element_size_; }
+    size_t ram_count() const { return ram_count_; }
+
+    // Current batch (slot batch() % depth)
+    uint8_t* observations() { return slot(batch()) + observations_offset_; }
+    uint8_t* ram() { return slot(batch()) + ram_offset_; }
+    float* rewards() { return reinterpret_cast<float*>(slot(batch()) + rewards_offset_); }
+    bool* dones() { return reinterpret_cast<bool*>(slot(batch()) + dones_offset_); }
+
+    std::mutex& call_mutex() { return call_mutex_; }
+
+    // Shared header and per-env counters (obs_ring.cpp)
+    struct Header;
+
+private:
+    void map(size_t size, bool create);
+    uint8_t* slot(uint32_t batch) { return batches_ + (batch % depth_) * batch_stride_; }
+
+    std::mutex call_mutex_;
+    std::string name_;
+    bool owner_;
+
+    int num_envs_;
+    int depth_;
+    size_t shape_[3];
+    size_t element_size_;
+    size_t observation_bytes_;
+    size_t ram_count_;
+
+    // Offsets of the arrays inside one batch
+    size_t observations_offset_;
+    size_t ram_offset_;
+    size_t rewards_offset_;
+    size_t dones_offset_;
+    size_t batch_stride_;
+
+    void* shared_;
+    size_t shared_size_;
+    Header* header_;
+    const uint32_t* ram_addresses_;
+    uint8_t* batches_;
+};
+
+} // namespace superpy
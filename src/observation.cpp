@@ -0,0 +1,213 @@
+/**
+ * SuperPy Observation Pipeline
+ *
+ * Turns the RGB565 framebuffer into the observation an agent actually
+ * consumes (e.g. 84x84 grayscale) in a single pass, without the RGBA
+ * intermediate that get_screen() produces.
+ */
+
+#include "observation.h"
+#include "pixel_convert.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace superpy {
+
+// Base SNES frame; hi-res and interlaced frames are 2x in either direction
+static constexpr int BASE_WIDTH = 256;
+static constexpr int BASE_HEIGHT = 224;
+
+ObsColor ObservationSpec::parse_color(const std::string& name) {
+    if (name == "rgb") return ObsColor::RGB;
+    if (name == "gray" || name == "grey") return ObsColor::Gray;
+    if (name == "rgb565") return ObsColor::RGB565;
+    if (name == "palette") return ObsColor::Palette;
+    throw std::invalid_argument("unknown observation color '" + name + "' (expected rgb, gray, rgb565 or palette)");
+}
+
+ObsInterpolation ObservationSpec::parse_interpolation(const std::string& name) {
+    if (name == "nearest") return ObsInterpolation::Nearest;
+    if (name == "area") return ObsInterpolation::Area;
+    throw std::invalid_argument("unknown interpolation '" + name + "' (expected nearest or area)");
+}
+
+ObsLayout ObservationSpec::parse_layout(const std::string& name) {
+    if (name == "hwc") return ObsLayout::HWC;
+    if (name == "chw") return ObsLayout::CHW;
+    throw std::invalid_argument("unknown layout '" + name + "' (expected hwc or chw)");
+}
+
+ObservationPipeline::ObservationPipeline(const ObservationSpec& spec)
+    : spec_(spec), prepared_width_(0), prepared_height_(0) {
+    if (spec.crop_x < 0 || spec.crop_y < 0 || spec.crop_width < 0 || spec.crop_height < 0 ||
+        spec.crop_x >= BASE_WIDTH || spec.crop_y >= BASE_HEIGHT ||
+        spec.crop_x + spec.crop_width > BASE_WIDTH || spec.crop_y + spec.crop_height > BASE_HEIGHT) {
+        throw std::invalid_argument("crop rectangle must lie inside the 256x224 frame");
+    }
+    if (spec.width < 0 || spec.height < 0) {
+        throw std::invalid_argument("observation size must not be negative");
+    }
+
+    int crop_width = spec.crop_width ? spec.crop_width : BASE_WIDTH - spec.crop_x;
+    int crop_height = spec.crop_height ? spec.crop_height : BASE_HEIGHT - spec.crop_y;
+    width_ = spec.width ? spec.width : crop_width;
+    height_ = spec.height ? spec.height : crop_height;
+}
+
+int ObservationPipeline::channels() const {
+    return spec_.color == ObsColor::RGB ? 3 : 1;
+}
+
+size_t ObservationPipeline::element_size() const {
+    return spec_.color == ObsColor::RGB565 ? sizeof(uint16_t) : sizeof(uint8_t);
+}
+
+size_t ObservationPipeline::size_bytes() const {
+    return static_cast<size_t>(width_) * height_ * channels() * element_size();
+}
+
+void ObservationPipeline::shape(size_t out[3]) const {
+    if (spec_.layout == ObsLayout::CHW) {
+        out[0] = channels();
+        out[1] = height_;
+        out[2] = width_;
+    } else {
+        out[0] = height_;
+        out[1] = width_;
+        out[2] = channels();
+    }
+}
+
+// Build one axis of the sampling tables
+static void build_axis(int crop_start, int crop_size, int out_size, bool area,
+                       std::vector<int>& begin, std::vector<int>& end) {
+    begin.resize(out_size);
+    end.resize(out_size);
+
+    for (int i = 0; i < out_size; i++) {
+        if (area) {
+            begin[i] = crop_start + i * crop_size / out_size;
+            end[i] = std::max(crop_start + (i + 1) * crop_size / out_size, begin[i] + 1);
+        } else {
+            // Sample the source pixel under the output pixel's center
+            begin[i] = crop_start + (2 * i + 1) * crop_size / (2 * out_size);
+            end[i] = begin[i] + 1;
+        }
+    }
+}
+
+void ObservationPipeline::prepare(int src_width, int src_height) {
+    int scale_x = src_width >= 2 * BASE_WIDTH ? 2 : 1;
+    int scale_y = src_height >= 2 * BASE_HEIGHT ? 2 : 1;
+
+    int x0 = std::min(spec_.crop_x * scale_x, src_width - 1);
+    int y0 = std::min(spec_.crop_y * scale_y, src_height - 1);
+    int w = spec_.crop_width ? spec_.crop_width * scale_x : src_width - x0;
+    int h = spec_.crop_height ? spec_.crop_height * scale_y : src_height - y0;
+    w = std::max(1, std::min(w, src_width - x0));
+    h = std::max(1, std::min(h, src_height - y0));
+
+    bool area = spec_.interpolation == ObsInterpolation::Area;
+    build_axis(x0, w, width_, area, x_begin_, x_end_);
+    build_axis(y0, h, height_, area, y_begin_, y_end_);
+
+    prepared_width_ = src_width;
+    prepared_height_ = src_height;
+}
+
+void ObservationPipeline::apply(const uint16_t* src, int pitch, int src_width, int src_height, void* dst) {
+    if (src_width != prepared_width_ || src_height != prepared_height_) {
+        prepare(src_width, src_height);
+    }
+
+    const bool area = spec_.interpolation == ObsInterpolation::Area;
+    const bool chw = spec_.layout == ObsLayout::CHW;
+    const size_t plane = static_cast<size_t>(width_) * height_;
+    uint8_t* out8 = static_cast<uint8_t*>(dst);
+    uint16_t* out16 = static_cast<uint16_t*>(dst);
+
+    for (int y = 0; y < height_; y++) {
+        for (int x = 0; x < width_; x++) {
+            size_t index = static_cast<size_t>(y) * width_ + x;
+
+            // Native pixels need no expansion at all
+            if (spec_.color == ObsColor::RGB565 && !area) {
+                out16[index] = src[y_begin_[y] * pitch + x_begin_[x]];
+                continue;
+            }
+
+            // Expanded 8-bit channels, averaged over the source box
+            uint32_t r = 0, g = 0, b = 0, n = 0;
+            for (int sy = y_begin_[y]; sy < y_end_[y]; sy++) {
+                const uint16_t* row = src + sy * pitch;
+                for (int sx = x_begin_[x]; sx < x_end_[x]; sx++) {
+                    uint32_t rgba = rgb565_to_rgba_pixel(row[sx], spec_.full_range);
+                    r += rgba & 0xFF;
+                    g += (rgba >> 8) & 0xFF;
+                    b += (rgba >> 16) & 0xFF;
+                    n++;
+                }
+            }
+            r /= n;
+            g /= n;
+            b /= n;
+
+            switch (spec_.color) {
+                case ObsColor::RGB:
+                    if (chw) {
+                        out8[index] = r;
+                        out8[plane + index] = g;
+                        out8[2 * plane + index] = b;
+                    } else {
+                        out8[3 * index] = r;
+                        out8[3 * index + 1] = g;
+                        out8[3 * index + 2] = b;
+                    }
+                    break;
+                case ObsColor::Gray:
+                    out8[index] = (77 * r + 150 * g + 29 * b) >> 8;
+                    break;
+                case ObsColor::RGB565:
+                    out16[index] = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+                    break;
+                case ObsColor::Palette:
+                    out8[index] = (r & 0xE0) | ((g >> 3) & 0x1C) | (b >> 6);
+                    break;
+            }
+        }
+    }
+}
+
+void ObservationPipeline::max_pool(void* dst, const void* other) const {
+    size_t count = static_cast<size_t>(width_) * height_ * channels();
+
+    // Packed formats pool each channel field separately
+    if (spec_.color == ObsColor::RGB565) {
+        uint16_t* a = static_cast<uint16_t*>(dst);
+        const uint16_t* b = static_cast<const uint16_t*>(other);
+        for (size_t i = 0; i < count; i++) {
+            a[i] = std::max(a[i] & 0xF800, b[i] & 0xF800) |
+                   std::max(a[i] & 0x07E0, b[i] & 0x07E0) |
+                   std::max(a[i] & 0x001F, b[i] & 0x001F);
+        }
+        return;
+    }
+
+    uint8_t* a = static_cast<uint8_t*>(dst);
+    const uint8_t* b = static_cast<const uint8_t*>(other);
+    if (spec_.color == ObsColor::Palette) {
+        for (size_t i = 0; i < count; i++) {
+            a[i] = std::max(a[i] & 0xE0, b[i] & 0xE0) |
+                   std::max(a[i] & 0x1C, b[i] & 0x1C) |
+                   std::max(a[i] & 0x03, b[i] & 0x03);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        a[i] = std::max(a[i], b[i]);
+    }
+}
+
+} // namespace superpy
@@ -0,0 +1,92 @@
+/**
+ * SuperPy Observation Pipeline
+ * Crop / resize / color conversion applied directly to the native frame
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace superpy {
+
+enum class ObsColor {
+    RGB,       // 3 x uint8
+    Gray,      // 1 x uint8 (BT.601 luma)
+    RGB565,    // 1 x uint16, the native pixel format
+    Palette,   // 1 x uint8, RGB332 color index
+};
+
+enum class ObsInterpolation {
+    Nearest,
+    Area,      // box average over the source pixels of each output pixel
+};
+
+enum class ObsLayout {
+    HWC,
+    CHW,
+};
+
+struct ObservationSpec {
+    // Crop rectangle in base 256x224 coordinates (scaled for hi-res frames).
+    // A zero width/height means "up to the frame edge".
+    int crop_x = 0;
+    int crop_y = 0;
+    int crop_width = 0;
+    int crop_height = 0;
+
+    // Output size, 0 = crop size
+    int width = 0;
+    int height = 0;
+
+    ObsInterpolation interpolation = ObsInterpolation::Nearest;
+    ObsColor color = ObsColor::RGB;
+    ObsLayout layout = ObsLayout::HWC;
+    bool full_range = false;
+
+    // Parse "rgb"/"gray"/"rgb565"/"palette", "nearest"/"area", "hwc"/"chw".
+    // Throw std::invalid_argument on unknown names.
+    static ObsColor parse_color(const std::string& name);
+    static ObsInterpolation parse_interpolation(const std::string& name);
+    static ObsLayout parse_layout(const std::string& name);
+};
+
+class ObservationPipeline {
+public:
+    // Throws std::invalid_argument if the spec does not fit a SNES frame
+    explicit ObservationPipeline(const ObservationSpec& spec);
+
+    const ObservationSpec& spec() const { return spec_; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int channels() const;
+    size_t element_size() const;
+    size_t size_bytes() const;
+
+    // (H, W, C) or (C, H, W)
+    void shape(size_t out[3]) const;
+
+    // Write one observation from an RGB565 frame into dst (size_bytes())
+    void apply(const uint16_t* src, int pitch, int src_width, int src_height, void* dst);
+
+    // dst = max(dst, other), per color channel (Atari-style frame pooling)
+    void max_pool(void* dst, const void* other) const;
+
+private:
+    void prepare(int src_width, int src_height);
+
+    ObservationSpec spec_;
+    int width_;
+    int height_;
+
+    // Source sampling tables for the current frame size. Nearest uses only
+    // the begin tables; Area averages over [begin, end).
+    int prepared_width_;
+    int prepared_height_;
+    std::vector<int> x_begin_, x_end_;
+    std::vector<int> y_begin_, y_end_;
+};
+
+} // namespace superpy
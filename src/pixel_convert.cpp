@@ -0,0 +1,168 @@
+/**
+ * SuperPy Pixel Conversion
+ *
+ * SSE2 and AVX2 kernels convert 8/16 pixels per iteration. Each channel is
+ * isolated in a 16-bit lane already positioned as an 8-bit value, then the
+ * lanes are interleaved into R,G,B,A bytes. The AVX2 kernel is compiled
+ * with a target attribute and only called after a runtime CPU check, so the
+ * module itself keeps the baseline instruction set. SSE2 is part of that
+ * baseline on x86-64; other architectures use the scalar loop.
+ */
+
+#include "pixel_convert.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SUPERPY_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(SUPERPY_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SUPERPY_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SUPERPY_TARGET_AVX2
+#endif
+
+namespace superpy {
+
+static void convert_scalar(const uint16_t* src, uint32_t* dst, size_t count, bool full_range) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = rgb565_to_rgba_pixel(src[i], full_range);
+    }
+}
+
+#if defined(SUPERPY_X86)
+
+static void convert_sse2(const uint16_t* src, uint32_t* dst, size_t count, bool full_range) {
+    const __m128i mask_r = _mm_set1_epi16(0x00F8);
+    const __m128i mask_g = _mm_set1_epi16(0x00FC);
+    const __m128i mask_b = _mm_set1_epi16(0x00F8);
+    const __m128i low2 = _mm_set1_epi16(0x0003);
+    const __m128i low3 = _mm_set1_epi16(0x0007);
+    const __m128i alpha = _mm_set1_epi16(static_cast<short>(0xFF00));
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+        __m128i r = _mm_and_si128(_mm_srli_epi16(p, 8), mask_r);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(p, 3), mask_g);
+        __m128i b = _mm_and_si128(_mm_slli_epi16(p, 3), mask_b);
+
+        if (full_range) {
+            r = _mm_or_si128(r, _mm_srli_epi16(p, 13));
+            g = _mm_or_si128(g, _mm_and_si128(_mm_srli_epi16(p, 9), low2));
+            b = _mm_or_si128(b, _mm_and_si128(_mm_srli_epi16(p, 2), low3));
+        }
+
+        __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+        __m128i ba = _mm_or_si128(b, alpha);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi16(rg, ba));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4), _mm_unpackhi_epi16(rg, ba));
+    }
+
+    convert_scalar(src + i, dst + i, count - i, full_range);
+}
+
+SUPERPY_TARGET_AVX2
+static void convert_avx2(const uint16_t* src, uint32_t* dst, size_t count, bool full_range) {
+    const __m256i mask_r = _mm256_set1_epi16(0x00F8);
+    const __m256i mask_g = _mm256_set1_epi16(0x00FC);
+    const __m256i mask_b = _mm256_set1_epi16(0x00F8);
+    const __m256i low2 = _mm256_set1_epi16(0x0003);
+    const __m256i low3 = _mm256_set1_epi16(0x0007);
+    const __m256i alpha = _mm256_set1_epi16(static_cast<short>(0xFF00));
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+
+        __m256i r = _mm256_and_si256(_mm256_srli_epi16(p, 8), mask_r);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi16(p, 3), mask_g);
+        __m256i b = _mm256_and_si256(_mm256_slli_epi16(p, 3), mask_b);
+
+        if (full_range) {
+            r = _mm256_or_si256(r, _mm256_srli_epi16(p, 13));
+            g = _mm256_or_si256(g, _mm256_and_si256(_mm256_srli_epi16(p, 9), low2));
+            b = _mm256_or_si256(b, _mm256_and_si256(_mm256_srli_epi16(p, 2), low3));
+        }
+
+        __m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+        __m256i ba = _mm256_or_si256(b, alpha);
+
+        // Unpacks work per 128-bit lane: lo = pixels 0-3, 8-11; hi = 4-7, 12-15
+        __m256i lo = _mm256_unpacklo_epi16(rg, ba);
+        __m256i hi = _mm256_unpackhi_epi16(rg, ba);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    convert_sse2(src + i, dst + i, count - i, full_range);
+}
+
+static bool cpu_has_avx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    // AVX2 needs OS support for the YMM state as well as the CPUID bit
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // SUPERPY_X86
+
+PixelIsa best_pixel_isa() {
+#if defined(SUPERPY_X86)
+    static const PixelIsa best = cpu_has_avx2() ? PixelIsa::AVX2 : PixelIsa::SSE2;
+    return best;
+#else
+    return PixelIsa::Scalar;
+#endif
+}
+
+bool pixel_isa_supported(PixelIsa isa) {
+    return isa <= best_pixel_isa();
+}
+
+const char* pixel_isa_name(PixelIsa isa) {
+    switch (isa) {
+        case PixelIsa::AVX2: return "avx2";
+        case PixelIsa::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+void rgb565_to_rgba(const uint16_t* src, uint32_t* dst, size_t count, bool full_range) {
+    rgb565_to_rgba(src, dst, count, full_range, best_pixel_isa());
+}
+
+void rgb565_to_rgba(const uint16_t* src, uint32_t* dst, size_t count, bool full_range, PixelIsa isa) {
+#if defined(SUPERPY_X86)
+    if (isa == PixelIsa::AVX2 && pixel_isa_supported(PixelIsa::AVX2)) {
+        convert_avx2(src, dst, count, full_range);
+        return;
+    }
+    if (isa != PixelIsa::Scalar) {
+        convert_sse2(src, dst, count, full_range);
+        return;
+    }
+#endif
+    convert_scalar(src, dst, count, full_range);
+}
+
+} // namespace superpy
@@ -0,0 +1,49 @@
+/**
+ * SuperPy Pixel Conversion
+ * RGB565 -> RGBA8888 kernels with runtime CPU dispatch
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace superpy {
+
+enum class PixelIsa {
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+// Best instruction set available on this CPU (detected once)
+PixelIsa best_pixel_isa();
+bool pixel_isa_supported(PixelIsa isa);
+const char* pixel_isa_name(PixelIsa isa);
+
+// Convert `count` RGB565 pixels to RGBA8888 (little-endian 0xAABBGGRR).
+// full_range: expand 5/6-bit channels by replicating their high bits, so
+// white maps to 255 instead of 248/252.
+void rgb565_to_rgba(const uint16_t* src, uint32_t* dst, size_t count, bool full_range);
+void rgb565_to_rgba(const uint16_t* src, uint32_t* dst, size_t count, bool full_range, PixelIsa isa);
+
+// Single pixel version, for paths that sample rather than stream
+inline uint32_t rgb565_to_rgba_pixel(uint16_t pixel, bool full_range) {
+    uint32_t r = (pixel >> 11) & 0x1F;
+    uint32_t g = (pixel >> 5) & 0x3F;
+    uint32_t b = pixel & 0x1F;
+
+    if (full_range) {
+        r = (r << 3) | (r >> 2);
+        g = (g << 2) | (g >> 4);
+        b = (b << 3) | (b >> 2);
+    } else {
+        r <<= 3;
+        g <<= 2;
+        b <<= 3;
+    }
+
+    return (0xFFu << 24) | (b << 16) | (g << 8) | r;
+}
+
+} // namespace superpy
@@ -0,0 +1,55 @@
+/**
+ * SuperPy Process Sync
+ * Waiting on 32-bit counters in memory shared between processes
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <ctime>
+#endif
+
+namespace superpy {
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared counters need lock-free atomics");
+
+// Spins briefly, then sleeps until `word` != old or about timeout_ms have
+// passed; returns whether it changed. Sleeps on a futex on Linux (not
+// FUTEX_PRIVATE: the word lives in shared memory), naps elsewhere. Callers
+// loop on timeouts to check that their peer is still alive.
+inline bool wait_change(std::atomic<uint32_t>& word, uint32_t old, int timeout_ms = 100) {
+    for (int i = 0; i < 4000; i++) {
+        if (word.load(std::memory_order_acquire) != old) return true;
+    }
+
+#if defined(__linux__)
+    timespec timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, old, &timeout, nullptr, 0);
+#elif !defined(_WIN32)
+    for (int slept = 0; slept < timeout_ms * 10; slept++) {
+        if (word.load(std::memory_order_acquire) != old) return true;
+        usleep(100);
+    }
+#endif
+    return word.load(std::memory_order_acquire) != old;
+}
+
+// Wake every process sleeping in wait_change() on `word`
+inline void wake_all(std::atomic<uint32_t>& word) {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+} // namespace superpy
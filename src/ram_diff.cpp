@@ -0,0 +1,131 @@
+/**
+ * SuperPy RAM Diff
+ *
+ * SSE2 and AVX2 kernels compare 16/32 bytes per iteration and turn the
+ * compare into a bit mask, so unchanged blocks (almost all of WRAM from one
+ * frame to the next) cost one compare and one branch. Only blocks with a
+ * difference walk their set bits. As in pixel_convert.cpp, the AVX2 kernel
+ * is compiled with a target attribute and picked at runtime.
+ */
+
+#include "ram_diff.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SUPERPY_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(SUPERPY_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SUPERPY_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SUPERPY_TARGET_AVX2
+#endif
+
+namespace superpy {
+
+namespace {
+
+// Collects the differing bytes of one block at a time
+struct DiffWriter {
+    const uint8_t* reference;
+    const uint8_t* current;
+    uint32_t* indices;
+    uint8_t* old_values;
+    uint8_t* new_values;
+    size_t max;
+    size_t count = 0;
+
+    void add(size_t index) {
+        if (count < max) {
+            indices[count] = static_cast<uint32_t>(index);
+            old_values[count] = reference[index];
+            new_values[count] = current[index];
+        }
+        count++;
+    }
+
+    // Every set bit of mask is a differing byte at base + bit
+    void add_mask(size_t base, uint32_t mask) {
+        while (mask) {
+#if defined(_MSC_VER)
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+#else
+            int bit = __builtin_ctz(mask);
+#endif
+            add(base + bit);
+            mask &= mask - 1;
+        }
+    }
+};
+
+size_t diff_scalar(DiffWriter& out, uint8_t* reference, const uint8_t* current, size_t start, size_t size,
+                   bool update) {
+    for (size_t i = start; i < size; i++) {
+        if (reference[i] != current[i]) {
+            out.add(i);
+            if (update) reference[i] = current[i];
+        }
+    }
+    return out.count;
+}
+
+#if defined(SUPERPY_X86)
+
+size_t diff_sse2(DiffWriter& out, uint8_t* reference, const uint8_t* current, size_t start, size_t size,
+                 bool update) {
+    size_t i = start;
+    for (; i + 16 <= size; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(reference + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current + i));
+        uint32_t changed = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b))) & 0xFFFF;
+        if (!changed) continue;
+
+        out.add_mask(i, changed);
+        if (update) _mm_storeu_si128(reinterpret_cast<__m128i*>(reference + i), b);
+    }
+    return diff_scalar(out, reference, current, i, size, update);
+}
+
+SUPERPY_TARGET_AVX2
+size_t diff_avx2(DiffWriter& out, uint8_t* reference, const uint8_t* current, size_t size, bool update) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(reference + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current + i));
+        uint32_t changed = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+        if (!changed) continue;
+
+        out.add_mask(i, changed);
+        if (update) _mm256_storeu_si256(reinterpret_cast<__m256i*>(reference + i), b);
+    }
+    return diff_sse2(out, reference, current, i, size, update);
+}
+
+#endif // SUPERPY_X86
+
+} // namespace
+
+size_t diff_bytes(uint8_t* reference, const uint8_t* current, size_t size, uint32_t* indices,
+                  uint8_t* old_values, uint8_t* new_values, size_t max, bool update) {
+    return diff_bytes(reference, current, size, indices, old_values, new_values, max, update, best_pixel_isa());
+}
+
+size_t diff_bytes(uint8_t* reference, const uint8_t* current, size_t size, uint32_t* indices,
+                  uint8_t* old_values, uint8_t* new_values, size_t max, bool update, PixelIsa isa) {
+    DiffWriter out{reference, current, indices, old_values, new_values, max};
+#if defined(SUPERPY_X86)
+    if (isa == PixelIsa::AVX2 && pixel_isa_supported(PixelIsa::AVX2)) {
+        return diff_avx2(out, reference, current, size, update);
+    }
+    if (isa != PixelIsa::Scalar) {
+        return diff_sse2(out, reference, current, 0, size, update);
+    }
+#endif
+    return diff_scalar(out, reference, current, 0, size, update);
+}
+
+} // namespace superpy
@@ -0,0 +1,26 @@
+/**
+ * SuperPy RAM Diff
+ * Changed bytes between two memory images with SIMD compares
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pixel_convert.h"
+
+namespace superpy {
+
+// Compare `size` bytes of `reference` against `current`. The index, old
+// (reference) and new (current) value of the first `max` bytes that differ
+// are written in address order; returns how many bytes differ in total.
+// update: copy the differing blocks of `current` into `reference`, which
+// then equals `current` without rewriting the unchanged bytes.
+// Uses the same instruction sets as the pixel kernels (see PixelIsa).
+size_t diff_bytes(uint8_t* reference, const uint8_t* current, size_t size, uint32_t* indices,
+                  uint8_t* old_values, uint8_t* new_values, size_t max, bool update);
+size_t diff_bytes(uint8_t* reference, const uint8_t* current, size_t size, uint32_t* indices,
+                  uint8_t* old_values, uint8_t* new_values, size_t max, bool update, PixelIsa isa);
+
+} // namespace superpy
@@ -0,0 +1,92 @@
+/**
+ * SuperPy RAM Features
+ */
+
+#include "ram_features.h"
+
+#include <stdexcept>
+
+namespace superpy {
+
+static constexpr uint32_t WRAM_SIZE = 0x20000;
+
+RamType RamFeature::parse_type(const std::string& name) {
+    if (name == "u8") return RamType::U8;
+    if (name == "s8") return RamType::S8;
+    if (name == "u16") return RamType::U16;
+    if (name == "s16") return RamType::S16;
+    if (name == "u24") return RamType::U24;
+    throw std::invalid_argument("unknown RAM feature type '" + name + "' (expected u8, s8, u16, s16 or u24)");
+}
+
+FeatureDtype RamFeature::parse_dtype(const std::string& name) {
+    if (name == "float32") return FeatureDtype::Float32;
+    if (name == "int32") return FeatureDtype::Int32;
+    throw std::invalid_argument("unknown feature dtype '" + name + "' (expected float32 or int32)");
+}
+
+RamFeatures::RamFeatures(const std::vector<RamFeature>& features, FeatureDtype dtype) : dtype_(dtype) {
+    ops_.reserve(features.size());
+    for (const RamFeature& feature : features) {
+        Op op;
+        op.address = feature.address;
+        op.bytes = feature.type == RamType::U24 ? 3 : feature.type == RamType::U16 || feature.type == RamType::S16 ? 2 : 1;
+        op.big_endian = feature.big_endian;
+        op.is_signed = feature.type == RamType::S8 || feature.type == RamType::S16;
+        op.bcd = feature.bcd;
+        op.mask = feature.mask ? feature.mask : 0xFFFFFFFFu;
+        op.scale = feature.scale;
+
+        std::string where = "RAM feature at " + std::to_string(feature.address);
+        if (feature.address > WRAM_SIZE - op.bytes) {
+            throw std::invalid_argument(where + " reaches past the end of the 128KB WRAM");
+        }
+        if (feature.shift < 0 || feature.shift >= 24) {
+            throw std::invalid_argument(where + ": shift must be in [0, 24)");
+        }
+        if (op.is_signed && (feature.bcd || feature.mask || feature.shift)) {
+            throw std::invalid_argument(where + ": BCD and bitfields need an unsigned type");
+        }
+        if (dtype == FeatureDtype::Int32 && feature.scale != 1.0f) {
+            throw std::invalid_argument(where + ": scale requires float32 output");
+        }
+        op.shift = static_cast<uint8_t>(feature.shift);
+        ops_.push_back(op);
+    }
+}
+
+int32_t RamFeatures::value(const Op& op, const uint8_t* ram) const {
+    const uint8_t* p = ram + op.address;
+    uint32_t raw = 0;
+    for (int i = 0; i < op.bytes; i++) {
+        int byte = op.big_endian ? i : op.bytes - 1 - i;
+        raw = raw << 8 | p[byte];
+    }
+
+    if (op.is_signed) {
+        int bits = 32 - 8 * op.bytes;
+        return static_cast<int32_t>(raw << bits) >> bits;
+    }
+
+    raw = (raw & op.mask) >> op.shift;
+    if (op.bcd) {
+        uint32_t decimal = 0;
+        for (int digit = 8 * op.bytes - 4; digit >= 0; digit -= 4) {
+            decimal = decimal * 10 + (raw >> digit & 0xF);
+        }
+        raw = decimal;
+    }
+    return static_cast<int32_t>(raw);
+}
+
+void RamFeatures::gather(const uint8_t* ram, void* dst) const {
+    if (dtype_ == FeatureDtype::Int32) {
+        int32_t* out = static_cast<int32_t*>(dst);
+        for (const Op& op : ops_) *out++ = value(op, ram);
+    } else {
+        float* out = static_cast<float*>(dst);
+        for (const Op& op : ops_) *out++ = static_cast<float>(value(op, ram)) * op.scale;
+    }
+}
+
+} // namespace superpy
@@ -0,0 +1,79 @@
+/**
+ * SuperPy RAM Features
+ * Game variables gathered from WRAM into a flat float32/int32 vector
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace superpy {
+
+enum class RamType {
+    U8,
+    S8,
+    U16,
+    S16,
+    U24,
+};
+
+enum class FeatureDtype {
+    Float32,
+    Int32,
+};
+
+struct RamFeature {
+    uint32_t address = 0;       // WRAM offset, 0-0x1FFFF
+    RamType type = RamType::U8;
+    bool big_endian = false;
+    bool bcd = false;           // packed BCD, two decimal digits per byte
+
+    // Bitfield: value = (value & mask) >> shift, a zero mask keeps every bit
+    uint32_t mask = 0;
+    int shift = 0;
+
+    float scale = 1.0f;         // float32 output only
+
+    // Parse "u8"/"s8"/"u16"/"s16"/"u24", "float32"/"int32".
+    // Throw std::invalid_argument on unknown names.
+    static RamType parse_type(const std::string& name);
+    static FeatureDtype parse_dtype(const std::string& name);
+};
+
+// A feature list checked and flattened once, then gathered after every step
+class RamFeatures {
+public:
+    // Throws std::invalid_argument for features reaching past WRAM,
+    // shifts outside [0, 24), BCD or bitfields on signed types, and a
+    // scale other than 1 with int32 output
+    RamFeatures(const std::vector<RamFeature>& features, FeatureDtype dtype);
+
+    size_t size() const { return ops_.size(); }
+    size_t size_bytes() const { return ops_.size() * 4; }
+    FeatureDtype dtype() const { return dtype_; }
+
+    // Write size() values of dtype() from the 128KB WRAM into dst
+    void gather(const uint8_t* ram, void* dst) const;
+
+private:
+    struct Op {
+        uint32_t address;
+        uint32_t mask;      // all ones without a bitfield
+        float scale;
+        uint8_t bytes;
+        uint8_t shift;
+        bool big_endian;
+        bool is_signed;
+        bool bcd;
+    };
+
+    int32_t value(const Op& op, const uint8_t* ram) const;
+
+    std::vector<Op> ops_;
+    FeatureDtype dtype_;
+};
+
+} // namespace superpy
@@ -0,0 +1,88 @@
+/**
+ * SuperPy RAM Watches
+ */
+
+#include "ram_watch.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace superpy {
+
+static constexpr uint32_t WRAM_SIZE = 0x20000;
+
+WatchKind RamWatch::parse_kind(const std::string& name) {
+    if (name == "changed") return WatchKind::Changed;
+    if (name == "equals") return WatchKind::Equals;
+    if (name == "rises") return WatchKind::Rises;
+    if (name == "falls") return WatchKind::Falls;
+    throw std::invalid_argument("unknown watch kind '" + name + "' (expected changed, equals, rises or falls)");
+}
+
+RamWatches::RamWatches(const std::vector<RamWatch>& watches) {
+    std::vector<RamFeature> values;
+    uint32_t offset = 0;
+    for (const RamWatch& watch : watches) {
+        kinds_.push_back(watch.kind);
+        targets_.push_back(watch.target);
+
+        // Changed reads its range from the snapshot; the feature is unused
+        if (watch.kind == WatchKind::Changed) {
+            uint32_t address = watch.value.address;
+            if (watch.length == 0 || address >= WRAM_SIZE || watch.length > WRAM_SIZE - address) {
+                throw std::invalid_argument("watch at " + std::to_string(address) +
+                                            ": range must be non-empty and inside the 128KB WRAM");
+            }
+            ranges_.push_back({address, watch.length, offset});
+            offset += watch.length;
+            values.push_back(RamFeature{});
+        } else {
+            ranges_.push_back({0, 0, 0});
+            values.push_back(watch.value);
+        }
+    }
+
+    values_ = std::make_unique<RamFeatures>(values, FeatureDtype::Int32);
+    previous_.assign(watches.size(), 0);
+    current_.assign(watches.size(), 0);
+    snapshot_.assign(offset, 0);
+}
+
+void RamWatches::arm(const uint8_t* ram) {
+    values_->gather(ram, previous_.data());
+    for (const Range& range : ranges_) {
+        memcpy(snapshot_.data() + range.offset, ram + range.address, range.length);
+    }
+}
+
+int RamWatches::check(const uint8_t* ram) {
+    values_->gather(ram, current_.data());
+
+    int fired = -1;
+    for (size_t i = 0; i < kinds_.size(); i++) {
+        int32_t prev = previous_[i];
+        int32_t now = current_[i];
+        int32_t target = targets_[i];
+        bool hit = false;
+        switch (kinds_[i]) {
+            case WatchKind::Changed: {
+                const Range& range = ranges_[i];
+                uint8_t* old = snapshot_.data() + range.offset;
+                if (memcmp(old, ram + range.address, range.length) != 0) {
+                    hit = true;
+                    memcpy(old, ram + range.address, range.length);
+                }
+                break;
+            }
+            case WatchKind::Equals: hit = now == target && prev != target; break;
+            case WatchKind::Rises: hit = prev < target && now >= target; break;
+            case WatchKind::Falls: hit = prev >= target && now < target; break;
+        }
+        if (hit && fired < 0) fired = static_cast<int>(i);
+    }
+
+    previous_.swap(current_);
+    return fired;
+}
+
+} // namespace superpy
@@ -0,0 +1,72 @@
+/**
+ * SuperPy RAM Watches
+ * Conditions on WRAM checked after every frame, used by tick() to stop a
+ * fast-forward on the frame something happens
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ram_features.h"
+
+namespace superpy {
+
+enum class WatchKind {
+    Changed,    // any of `length` bytes from the address differs
+    Equals,     // the value becomes `target` (differed on the previous frame)
+    Rises,      // the value crosses the threshold upwards: prev < target <= now
+    Falls,      // the value crosses the threshold downwards: prev >= target > now
+};
+
+struct RamWatch {
+    WatchKind kind = WatchKind::Changed;
+    // Address and decoding of the value (type, endian, BCD, bitfield);
+    // Changed only uses the address
+    RamFeature value;
+    uint32_t length = 1;    // Changed: bytes compared
+    int32_t target = 0;     // Equals: value, Rises/Falls: threshold
+
+    // Parse "changed"/"equals"/"rises"/"falls".
+    // Throws std::invalid_argument on unknown names.
+    static WatchKind parse_kind(const std::string& name);
+};
+
+// A checked watch list plus the previous frame's values. Each engine needs
+// its own copy.
+class RamWatches {
+public:
+    // Throws std::invalid_argument for empty or out-of-WRAM ranges and for
+    // values RamFeatures rejects
+    explicit RamWatches(const std::vector<RamWatch>& watches);
+
+    size_t size() const { return kinds_.size(); }
+
+    // Remember the current values: nothing fires until they change
+    void arm(const uint8_t* ram);
+
+    // After a frame: index of the first watch that fired (-1 if none), then
+    // remember the new values
+    int check(const uint8_t* ram);
+
+private:
+    struct Range {
+        uint32_t address;
+        uint32_t length;
+        uint32_t offset;    // into snapshot_
+    };
+
+    std::vector<WatchKind> kinds_;
+    std::vector<int32_t> targets_;
+    std::vector<Range> ranges_;         // Changed: bytes, else unused
+    std::unique_ptr<RamFeatures> values_;   // one int32 per watch (Changed: 0)
+    std::vector<int32_t> previous_;
+    std::vector<int32_t> current_;
+    std::vector<uint8_t> snapshot_;     // Changed ranges, back to back
+};
+
+} // namespace superpy
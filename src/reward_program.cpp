@@ -0,0 +1,407 @@
+/**
+ * SuperPy Reward Program
+ */
+
+#include "reward_program.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace superpy {
+
+static constexpr uint32_t WRAM_SIZE = 0x20000;
+
+// Operand of the integer operators: truncated, clamped to the int64 range
+// (the plain cast is undefined outside it) and NaN as 0
+static int64_t to_int(double value) {
+    if (!(value == value)) return 0;
+    if (value >= 9223372036854775808.0) return INT64_MAX;
+    if (value <= -9223372036854775808.0) return INT64_MIN;
+    return static_cast<int64_t>(value);
+}
+
+// Recursive descent straight to bytecode; delta() and friends parse their
+// argument twice, once as is and once reading the previous frame's values
+class RewardProgram::Compiler {
+public:
+    Compiler(RewardProgram& program, const char* what, const std::string& source)
+        : program_(program), what_(what), src_(source) {}
+
+    Code compile() {
+        skip_space();
+        if (pos_ == src_.size()) return code_;
+        parse_expr();
+        if (pos_ != src_.size()) fail("unexpected '" + src_.substr(pos_, 1) + "'");
+        return code_;
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::invalid_argument(std::string(what_) + " expression, position " + std::to_string(pos_) + ": " +
+                                    message);
+    }
+
+    void skip_space() {
+        while (pos_ < src_.size() && std::isspace(static_cast<unsigned char>(src_[pos_]))) pos_++;
+    }
+
+    // Match an operator token; a one-character operator never matches the
+    // start of a two-character one ("<" is not "<=" or "<<")
+    bool accept(const char* token) {
+        size_t n = std::strlen(token);
+        if (src_.compare(pos_, n, token) != 0) return false;
+        if (n == 1 && pos_ + 1 < src_.size()) {
+            char next = src_[pos_ + 1];
+            if (std::strchr("<>!", token[0]) && next == '=') return false;
+            if (std::strchr("<>&|", token[0]) && next == token[0]) return false;
+        }
+        pos_ += n;
+        skip_space();
+        return true;
+    }
+
+    void expect(const char* token) {
+        if (!accept(token)) fail(std::string("expected '") + token + "'");
+    }
+
+    std::string identifier() {
+        size_t start = pos_;
+        while (pos_ < src_.size() && (std::isalnum(static_cast<unsigned char>(src_[pos_])) || src_[pos_] == '_')) pos_++;
+        std::string name = src_.substr(start, pos_ - start);
+        skip_space();
+        return name;
+    }
+
+    double number() {
+        const char* begin = src_.c_str() + pos_;
+        char* end = nullptr;
+        double value;
+        if (begin[0] == '0' && (begin[1] == 'x' || begin[1] == 'X')) {
+            value = static_cast<double>(std::strtoull(begin + 2, &end, 16));
+            if (end == begin + 2) fail("expected hex digits");
+        } else {
+            value = std::strtod(begin, &end);
+            if (end == begin) fail("expected a number");
+        }
+        pos_ += end - begin;
+        if (pos_ < src_.size() && (std::isalnum(static_cast<unsigned char>(src_[pos_])) || src_[pos_] == '_')) {
+            fail("malformed number");
+        }
+        skip_space();
+        return value;
+    }
+
+    void emit(Op op, uint32_t arg = 0, double value = 0.0) {
+        code_.instrs.push_back({op, arg, value});
+        switch (op) {
+            case PUSH: case READ: case READ_PREV: case FRAME: depth_++; break;
+            case NEG: case NOT: case ABS: break;
+            case CLAMP: case SELECT: depth_ -= 2; break;
+            default: depth_--; break;
+        }
+        code_.max_depth = std::max(code_.max_depth, depth_);
+    }
+
+    void parse_expr() {
+        parse_binary(0);
+        if (accept("?")) {
+            parse_expr();
+            expect(":");
+            parse_expr();
+            emit(SELECT);
+        }
+    }
+
+    // Binary operators by precedence level, loosest first (as in C)
+    void parse_binary(int level) {
+        struct Binary { const char* token; Op op; };
+        static const std::vector<std::vector<Binary>> LEVELS = {
+            {{"||", OR}},
+            {{"&&", AND}},
+            {{"|", BIT_OR}},
+            {{"&", BIT_AND}},
+            {{"==", EQ}, {"!=", NE}},
+            {{"<=", LE}, {">=", GE}, {"<", LT}, {">", GT}},
+            {{"<<", SHL}, {">>", SHR}},
+            {{"+", ADD}, {"-", SUB}},
+            {{"*", MUL}, {"/", DIV}, {"%", MOD}},
+        };
+        if (level == static_cast<int>(LEVELS.size())) {
+            parse_unary();
+            return;
+        }
+
+        parse_binary(level + 1);
+        for (;;) {
+            const Binary* match = nullptr;
+            for (const Binary& binary : LEVELS[level]) {
+                if (accept(binary.token)) {
+                    match = &binary;
+                    break;
+                }
+            }
+            if (!match) return;
+            parse_binary(level + 1);
+            emit(match->op);
+        }
+    }
+
+    void parse_unary() {
+        if (accept("-")) {
+            parse_unary();
+            emit(NEG);
+        } else if (accept("!")) {
+            parse_unary();
+            emit(NOT);
+        } else if (accept("+")) {
+            parse_unary();
+        } else {
+            parse_primary();
+        }
+    }
+
+    void parse_primary() {
+        if (pos_ == src_.size()) fail("unexpected end of expression");
+        char c = src_[pos_];
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            emit(PUSH, 0, number());
+            return;
+        }
+        if (accept("(")) {
+            parse_expr();
+            expect(")");
+            return;
+        }
+        if (!std::isalpha(static_cast<unsigned char>(c)) && c != '_') fail(std::string("unexpected '") + c + "'");
+
+        size_t start = pos_;
+        std::string name = identifier();
+        Read read;
+        if (parse_read_type(name, read)) {
+            parse_read(read, start);
+        } else if (name == "frame") {
+            emit(FRAME, prev_ ? 1 : 0);
+        } else if (name == "prev") {
+            expect("(");
+            parse_prev();
+            expect(")");
+        } else if (name == "delta" || name == "increased" || name == "decreased" || name == "changed") {
+            expect("(");
+            size_t arg = pos_;
+            parse_expr();
+            pos_ = arg;
+            parse_prev();
+            expect(")");
+            emit(name == "delta" ? SUB : name == "increased" ? GT : name == "decreased" ? LT : NE);
+        } else if (name == "min" || name == "max" || name == "sum") {
+            expect("(");
+            parse_expr();
+            while (accept(",")) {
+                parse_expr();
+                emit(name == "min" ? MIN : name == "max" ? MAX : ADD);
+            }
+            expect(")");
+        } else if (name == "clamp") {
+            expect("(");
+            parse_expr();
+            expect(",");
+            parse_expr();
+            expect(",");
+            parse_expr();
+            expect(")");
+            emit(CLAMP);
+        } else if (name == "abs") {
+            expect("(");
+            parse_expr();
+            expect(")");
+            emit(ABS);
+        } else {
+            pos_ = start;
+            fail("unknown name '" + name + "'");
+        }
+    }
+
+    // The argument of prev(), with every read taken from last frame's values
+    void parse_prev() {
+        if (prev_) fail("prev(), delta() and the comparisons against the previous frame cannot be nested");
+        prev_ = true;
+        parse_expr();
+        prev_ = false;
+    }
+
+    static bool parse_read_type(const std::string& name, Read& read) {
+        struct Type { const char* name; uint8_t bytes; bool big_endian; bool is_signed; bool bcd; };
+        static const Type TYPES[] = {
+            {"u8", 1, false, false, false},   {"s8", 1, false, true, false},
+            {"u16", 2, false, false, false},  {"s16", 2, false, true, false},
+            {"u24", 3, false, false, false},
+            {"u16be", 2, true, false, false}, {"s16be", 2, true, true, false},
+            {"u24be", 3, true, false, false},
+            {"bcd8", 1, false, false, true},  {"bcd16", 2, false, false, true},
+            {"bcd24", 3, false, false, true},
+        };
+        for (const Type& type : TYPES) {
+            if (name == type.name) {
+                read = {0, type.bytes, type.big_endian, type.is_signed, type.bcd};
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void parse_read(Read& read, size_t start) {
+        expect("[");
+        if (pos_ == src_.size() || !std::isdigit(static_cast<unsigned char>(src_[pos_]))) {
+            fail("RAM read address must be a constant");
+        }
+        double address = number();
+        expect("]");
+        if (address != std::floor(address) || address < 0 || address > WRAM_SIZE - read.bytes) {
+            pos_ = start;
+            fail("RAM read reaches past the end of the 128KB WRAM");
+        }
+        read.address = static_cast<uint32_t>(address);
+
+        std::vector<Read>& reads = program_.reads_;
+        uint32_t index = static_cast<uint32_t>(std::find(reads.begin(), reads.end(), read) - reads.begin());
+        if (index == reads.size()) reads.push_back(read);
+        if (!prev_) {
+            emit(READ, index);
+            return;
+        }
+
+        std::vector<uint32_t>& slots = program_.prev_reads_;
+        uint32_t slot = static_cast<uint32_t>(std::find(slots.begin(), slots.end(), index) - slots.begin());
+        if (slot == slots.size()) slots.push_back(index);
+        emit(READ_PREV, slot);
+    }
+
+    RewardProgram& program_;
+    const char* what_;
+    const std::string& src_;
+    size_t pos_ = 0;
+    bool prev_ = false;
+    int depth_ = 0;
+    Code code_;
+};
+
+RewardProgram::RewardProgram(const std::string& reward, const std::string& terminated, const std::string& truncated)
+    : frame_(0), pending_reward_(0.0), terminated_(false), truncated_(false) {
+    reward_ = Compiler(*this, "reward", reward).compile();
+    terminated_code_ = Compiler(*this, "terminated", terminated).compile();
+    truncated_code_ = Compiler(*this, "truncated", truncated).compile();
+
+    prev_.assign(prev_reads_.size(), 0.0);
+    int depth = std::max({reward_.max_depth, terminated_code_.max_depth, truncated_code_.max_depth});
+    stack_.assign(depth, 0.0);
+}
+
+double RewardProgram::read(const Read& r, const uint8_t* ram) {
+    const uint8_t* p = ram + r.address;
+    uint32_t raw = 0;
+    for (int i = 0; i < r.bytes; i++) {
+        int byte = r.big_endian ? i : r.bytes - 1 - i;
+        raw = raw << 8 | p[byte];
+    }
+
+    if (r.is_signed) {
+        int bits = 32 - 8 * r.bytes;
+        return static_cast<double>(static_cast<int32_t>(raw << bits) >> bits);
+    }
+    if (r.bcd) {
+        uint32_t decimal = 0;
+        for (int digit = 8 * r.bytes - 4; digit >= 0; digit -= 4) {
+            decimal = decimal * 10 + (raw >> digit & 0xF);
+        }
+        raw = decimal;
+    }
+    return static_cast<double>(raw);
+}
+
+double RewardProgram::run(const Code& code, const uint8_t* ram) {
+    double* sp = stack_.data();   // one past the top
+    for (const Instr& in : code.instrs) {
+        switch (in.op) {
+            case PUSH: *sp++ = in.value; continue;
+            case READ: *sp++ = read(reads_[in.arg], ram); continue;
+            case READ_PREV: *sp++ = prev_[in.arg]; continue;
+            case FRAME: *sp++ = static_cast<double>(frame_) - in.arg; continue;
+            case NEG: sp[-1] = -sp[-1]; continue;
+            case NOT: sp[-1] = sp[-1] == 0.0; continue;
+            case ABS: sp[-1] = std::fabs(sp[-1]); continue;
+            case CLAMP:
+                sp -= 2;
+                sp[-1] = std::min(std::max(sp[-1], sp[0]), sp[1]);
+                continue;
+            case SELECT:
+                sp -= 2;
+                sp[-1] = sp[-1] != 0.0 ? sp[0] : sp[1];
+                continue;
+            default: break;
+        }
+
+        double b = *--sp;
+        double& a = sp[-1];
+        switch (in.op) {
+            case ADD: a += b; break;
+            case SUB: a -= b; break;
+            case MUL: a *= b; break;
+            case DIV: a = b != 0.0 ? a / b : 0.0; break;
+            case MOD: {
+                int64_t ib = to_int(b);
+                // x % -1 is 0, but INT64_MIN % -1 overflows
+                a = ib != 0 && ib != -1 ? static_cast<double>(to_int(a) % ib) : 0.0;
+                break;
+            }
+            case MIN: a = std::min(a, b); break;
+            case MAX: a = std::max(a, b); break;
+            case EQ: a = a == b; break;
+            case NE: a = a != b; break;
+            case LT: a = a < b; break;
+            case LE: a = a <= b; break;
+            case GT: a = a > b; break;
+            case GE: a = a >= b; break;
+            case AND: a = a != 0.0 && b != 0.0; break;
+            case OR: a = a != 0.0 || b != 0.0; break;
+            case BIT_AND: a = static_cast<double>(to_int(a) & to_int(b)); break;
+            case BIT_OR: a = static_cast<double>(to_int(a) | to_int(b)); break;
+            case SHL: {
+                // Unsigned: shifting a negative or into the sign bit is undefined
+                int64_t n = std::min<int64_t>(std::max<int64_t>(to_int(b), 0), 63);
+                a = static_cast<double>(static_cast<int64_t>(static_cast<uint64_t>(to_int(a)) << n));
+                break;
+            }
+            case SHR: a = static_cast<double>(to_int(a) >> std::min<int64_t>(std::max<int64_t>(to_int(b), 0), 63)); break;
+            default: break;
+        }
+    }
+    return stack_[0];
+}
+
+void RewardProgram::arm(const uint8_t* ram) {
+    frame_ = 0;
+    pending_reward_ = 0.0;
+    terminated_ = false;
+    truncated_ = false;
+    for (size_t i = 0; i < prev_.size(); i++) prev_[i] = read(reads_[prev_reads_[i]], ram);
+}
+
+void RewardProgram::frame(const uint8_t* ram) {
+    frame_++;
+    if (!reward_.empty()) pending_reward_ += run(reward_, ram);
+    if (!terminated_code_.empty() && run(terminated_code_, ram) != 0.0) terminated_ = true;
+    if (!truncated_code_.empty() && run(truncated_code_, ram) != 0.0) truncated_ = true;
+    for (size_t i = 0; i < prev_.size(); i++) prev_[i] = read(reads_[prev_reads_[i]], ram);
+}
+
+float RewardProgram::take_reward() {
+    float reward = static_cast<float>(pending_reward_);
+    pending_reward_ = 0.0;
+    return reward;
+}
+
+} // namespace superpy
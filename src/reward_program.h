@@ -0,0 +1,107 @@
+/**
+ * SuperPy Reward Program
+ * Reward and termination expressions over RAM, compiled to a small stack
+ * bytecode and evaluated natively after every emulated frame
+ *
+ * Expressions (C-like precedence, values are doubles, true = 1):
+ *   u8[0x94] s8[..] u16[..] s16[..] u24[..]   little-endian RAM reads
+ *   u16be[..] s16be[..] u24be[..]             big-endian
+ *   bcd8[..] bcd16[..] bcd24[..]              packed BCD, little-endian
+ *   frame                                     frames since the episode start
+ *   prev(e)            e on the previous frame's RAM
+ *   delta(e)           e - prev(e)
+ *   increased(e) decreased(e) changed(e)      e vs prev(e)
+ *   min(a, b, ...) max(a, b, ...) sum(a, b, ...) clamp(x, lo, hi) abs(x)
+ *   + - * / %  == != < <= > >=  && || !  & | << >>  c ? a : b
+ * Division and modulo by zero give 0; bitwise operators and % work on
+ * integers. Read addresses are WRAM offsets and must be constants.
+ *
+ * Example: reward  "delta(bcd24[0x0F34]) - 100 * decreased(u8[0x0DBE])"
+ *          terminated "u8[0x0DBE] == 0",  truncated "frame >= 18000"
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace superpy {
+
+class RewardProgram {
+public:
+    // Each expression may be empty (reward 0, never terminated/truncated).
+    // Throws std::invalid_argument, with the position, on syntax errors,
+    // unknown names and reads past the 128KB WRAM.
+    RewardProgram(const std::string& reward, const std::string& terminated, const std::string& truncated);
+
+    // Start an episode on the current RAM: prev() reads it on the next
+    // frame, frame restarts at 0, the reward and both flags are cleared
+    void arm(const uint8_t* ram);
+
+    // Evaluate after an emulated frame: adds to the pending reward and
+    // latches terminated/truncated until the next arm()
+    void frame(const uint8_t* ram);
+
+    // Reward accumulated since the last take_reward() or arm()
+    float take_reward();
+    bool terminated() const { return terminated_; }
+    bool truncated() const { return truncated_; }
+
+private:
+    enum Op : uint8_t {
+        PUSH, READ, READ_PREV, FRAME,
+        NEG, NOT, ABS,
+        ADD, SUB, MUL, DIV, MOD, MIN, MAX,
+        EQ, NE, LT, LE, GT, GE, AND, OR,
+        BIT_AND, BIT_OR, SHL, SHR,
+        CLAMP, SELECT,
+    };
+
+    // A RAM read, decoded the same way whether current or previous
+    struct Read {
+        uint32_t address;
+        uint8_t bytes;
+        bool big_endian;
+        bool is_signed;
+        bool bcd;
+
+        bool operator==(const Read& other) const {
+            return address == other.address && bytes == other.bytes && big_endian == other.big_endian &&
+                   is_signed == other.is_signed && bcd == other.bcd;
+        }
+    };
+
+    struct Instr {
+        Op op;
+        uint32_t arg;   // READ: reads_ index, READ_PREV: prev slot
+        double value;   // PUSH
+    };
+
+    struct Code {
+        std::vector<Instr> instrs;
+        int max_depth = 0;
+        bool empty() const { return instrs.empty(); }
+    };
+
+    class Compiler;
+
+    double run(const Code& code, const uint8_t* ram);
+    static double read(const Read& r, const uint8_t* ram);
+
+    Code reward_;
+    Code terminated_code_;
+    Code truncated_code_;
+    std::vector<Read> reads_;
+    std::vector<uint32_t> prev_reads_;   // reads_ index of each prev slot
+    std::vector<double> prev_;           // value of each prev slot last frame
+    std::vector<double> stack_;
+
+    uint32_t frame_;
+    double pending_reward_;
+    bool terminated_;
+    bool truncated_;
+};
+
+} // namespace superpy
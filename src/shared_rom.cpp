@@ -0,0 +1,67 @@
+/**
+ * SuperPy Shared ROM
+ *
+ * Snes9x post-processes ROMs while loading them (copier headers,
+ * interleaving), so the file itself cannot be mapped. The first engine to
+ * load a ROM publishes its processed bytes here; later engines load
+ * normally, check that their bytes match and switch over to the shared
+ * image, releasing their own copy.
+ */
+
+#include "shared_rom.h"
+#include "emulator_core.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+namespace superpy {
+
+namespace {
+
+std::mutex cache_mutex;
+std::map<std::string, std::weak_ptr<const SharedRom>> cache;
+
+} // namespace
+
+std::shared_ptr<const SharedRom> SharedRom::get(const std::string& path, const uint8_t* data, size_t size) {
+#if defined(_WIN32)
+    (void)path; (void)data; (void)size;
+    return nullptr;
+#else
+    if (!data || size == 0 || size > SHARED_ROM_CAPACITY) return nullptr;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    if (auto image = cache[path].lock()) {
+        if (image->size() == size && std::memcmp(image->data(), data, size) == 0) {
+            return image;
+        }
+    }
+
+    // Anonymous mappings start zero-filled, like Snes9x's ROM buffer
+    size_t region_size = SHARED_ROM_GUARD + SHARED_ROM_CAPACITY;
+    void* region = mmap(nullptr, region_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) return nullptr;
+
+    uint8_t* bytes = static_cast<uint8_t*>(region);
+    std::memcpy(bytes + SHARED_ROM_GUARD, data, size);
+    mprotect(region, region_size, PROT_READ);
+
+    std::shared_ptr<const SharedRom> image(new SharedRom(bytes, region_size, SHARED_ROM_GUARD, size));
+    cache[path] = image;
+    return image;
+#endif
+}
+
+SharedRom::~SharedRom() {
+#if !defined(_WIN32)
+    munmap(region_, region_size_);
+#endif
+}
+
+} // namespace superpy
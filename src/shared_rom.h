@@ -0,0 +1,46 @@
+/**
+ * SuperPy Shared ROM
+ * One read-only copy of each ROM for every engine in the process
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace superpy {
+
+// A read-only ROM image in an anonymous shared mapping, laid out as
+// EmulatorCore::share_rom expects. Engines hold a reference while their
+// core reads from it. Worker processes forked afterwards inherit the
+// mapping, so they share the same physical pages too.
+class SharedRom {
+public:
+    // Image of the ROM loaded from `path` with the given (processed) bytes.
+    // Returns the cached image if one with the same bytes is alive,
+    // otherwise a new one. Returns null where shared images are not
+    // supported or the mapping fails; callers keep their private copy.
+    static std::shared_ptr<const SharedRom> get(const std::string& path, const uint8_t* data, size_t size);
+
+    ~SharedRom();
+
+    SharedRom(const SharedRom&) = delete;
+    SharedRom& operator=(const SharedRom&) = delete;
+
+    // Start of the ROM bytes inside the mapping
+    const uint8_t* data() const { return region_ + guard_; }
+    size_t size() const { return size_; }
+
+private:
+    SharedRom(uint8_t* region, size_t region_size, size_t guard, size_t size)
+        : region_(region), region_size_(region_size), guard_(guard), size_(size) {}
+
+    uint8_t* region_;
+    size_t region_size_;
+    size_t guard_;
+    size_t size_;
+};
+
+} // namespace superpy
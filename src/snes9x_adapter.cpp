@@ -1,382 +1,567 @@
 /**
  * SuperPy Snes9x Adapter
  * 
- * This file provides a headless interface to the Snes9x emulator core.
- * It implements the minimal platform-specific functions required by Snes9x
- * without any GUI dependencies.
+ * This file implements the engine on top of a private copy of the Snes9x
+ * core (see emulator_core.h). It never touches the Snes9x globals directly,
+ * only the headers for constants.
  */
 
 #include "snes9x_adapter.h"
+#include "core_loader.h"
+#include "pixel_convert.h"
+#include "ram_diff.h"
+#include "shared_rom.h"
 
-// Snes9x headers
+// Snes9x headers (constants only)
 #include "snes9x.h"
-#include "memmap.h"
-#include "apu/apu.h"
-#include "gfx.h"
-#include "snapshot.h"
-#include "controls.h"
-#include "display.h"
-#include "ppu.h"
-#include "cpuexec.h"
-#include "movie.h"
-#include "fscompat.h"
 
+#include <algorithm>
 #include <cstring>
-#include <cstdlib>
-#include <cstdio>
+#include <stdexcept>
 #include <string>
 
 namespace superpy {
 
-// Global screen buffer (RGBA, up to 512x478 for hi-res/interlaced modes)
+// Screen dimensions (RGBA, up to 512x478 for hi-res/interlaced modes)
 static constexpr int SCREEN_WIDTH = SNES_WIDTH;      // 256
 static constexpr int SCREEN_HEIGHT = SNES_HEIGHT;    // 224
 static constexpr int MAX_SNES_W = MAX_SNES_WIDTH;    // 512
 static constexpr int MAX_SNES_H = MAX_SNES_HEIGHT;   // 478
 
-static uint32_t rgba_buffer[MAX_SNES_W * MAX_SNES_H];
-
-SuperPyEngine::SuperPyEngine() : initialized_(false), done_(false), frame_count_(0) {
-    memset(&Settings, 0, sizeof(Settings));
+SuperPyEngine::SuperPyEngine(bool video)
+    : library_(CoreLibrary::open()),
+      core_(library_->create_core()),
+      rgba_buffer_(MAX_SNES_W * MAX_SNES_H, 0),
+      next_reset_state_(0),
+      rewind_depth_(0), rewind_stride_(0), rewind_buffer_(0),
+      state_size_(0),
+      trace_capacity_(65536),
+      profiling_(false),
+      full_range_color_(false),
+      video_(video),
+      initialized_(false), done_(false), frame_count_(0) {
+    core_->set_video(video_);
 }
 
 SuperPyEngine::~SuperPyEngine() {
-    if (initialized_) {
-        S9xDeinitAPU();
-        Memory.Deinit();
-        S9xGraphicsDeinit();
-    }
+    // The core's code lives in the library, so it must go first; it may
+    // also still be reading the shared ROM image
+    core_.reset();
+    rom_image_.reset();
+    library_.reset();
 }
 
 bool SuperPyEngine::load_rom(const std::string& path) {
-    // Initialize settings for headless operation
-    Settings.MouseMaster = false;
-    Settings.SuperScopeMaster = false;
-    Settings.JustifierMaster = false;
-    Settings.MultiPlayer5Master = false;
-    Settings.FrameTimePAL = 20000;
-    Settings.FrameTimeNTSC = 16667;
-    Settings.SixteenBitSound = true;
-    Settings.Stereo = true;
-    Settings.SoundPlaybackRate = 32000;
-    Settings.SoundInputRate = 32000;
-    Settings.Transparency = true;
-    Settings.AutoDisplayMessages = false;
-    Settings.InitialInfoStringTimeout = 0;
-    Settings.HDMATimingHack = 100;
-    Settings.BlockInvalidVRAMAccessMaster = true;
-    Settings.StopEmulation = false;
-    Settings.SkipFrames = 0;
-    Settings.TurboSkipFrames = 15;
-    Settings.MaxSpriteTilesPerLine = 34;  // Critical for sprite rendering
-    Settings.OneClockCycle = 6;
-    Settings.OneSlowClockCycle = 8;
-    Settings.TwoClockCycles = 12;
-    Settings.CartAName[0] = '\0';
-    Settings.CartBName[0] = '\0';
-
-    // Initialize memory
-    if (!Memory.Init()) {
-        return false;
-    }
-
-    // Initialize APU (required even without audio output)
-    if (!S9xInitAPU()) {
-        Memory.Deinit();
-        return false;
-    }
-
-    // Initialize sound buffers (also required for timing)
-    if (!S9xInitSound(0)) {
-        S9xDeinitAPU();
-        Memory.Deinit();
-        return false;
+    if (initialized_) {
+        // Snes9x cannot load a second ROM in place: deinitialize this copy
+        // of the core (its globals live in the library), then initialize it
+        // again. The old core must be gone before the new one touches them.
+        core_.reset();
+        core_ = library_->create_core();
+        core_->set_video(video_);
+        core_->set_profiling(profiling_);
+        if (tracing()) core_->set_trace(trace_watch_.data(), trace_capacity_);
+        rom_image_.reset();
+        initialized_ = false;
     }
+    frame_count_ = 0;
+    state_size_ = 0;
+    reset_states_.clear();
+    ram_reference_.clear();
 
-    // Initialize graphics subsystem
-    if (!S9xGraphicsInit()) {
-        S9xDeinitAPU();
-        Memory.Deinit();
-        return false;
+    initialized_ = core_->load_rom(path.c_str());
+    if (initialized_) {
+        // Switch to the process-wide copy of this ROM, if the cart allows it
+        auto image = SharedRom::get(path, core_->rom_data(), core_->rom_size());
+        if (image && core_->share_rom(image->data())) {
+            rom_image_ = image;
+        }
     }
-    
-    // Load the ROM
-    if (!Memory.LoadROM(path.c_str())) {
-        S9xGraphicsDeinit();
-        S9xDeinitAPU();
-        Memory.Deinit();
-        return false;
+    if (initialized_ && rewind_enabled()) {
+        start_rewind();
     }
-
-    // Set up controls (standard joypad on port 1)
-    S9xSetController(0, CTL_JOYPAD, 0, 0, 0, 0);
-    S9xSetController(1, CTL_NONE, 0, 0, 0, 0);
-
-    // Try to load SRAM if it exists
-    std::string sram_path = path + ".srm";
-    Memory.LoadSRAM(sram_path.c_str());
-
-    initialized_ = true;
-    return true;
+    start_episode();
+    return initialized_;
 }
 
 void SuperPyEngine::step(uint32_t joypad_state) {
     if (!initialized_) return;
 
     // Set the joypad state for player 1 (index 0)
-    MovieSetJoypad(0, joypad_state);
+    core_->set_joypad(0, joypad_state);
 
     // Run one frame
-    S9xMainLoop();
-    frame_count_++;
+    watch_hit_ = WatchHit{};
+    run_frame(true);
 }
 
-
-void SuperPyEngine::tick(int count, bool render, uint32_t joypad_state) {
+void SuperPyEngine::run_frames(uint32_t joypad_state, int count, bool render_last) {
     if (!initialized_) return;
+
+    core_->set_joypad(0, joypad_state);
+    watch_hit_ = WatchHit{};
+    for (int i = 1; i <= count; i++) {
+        run_frame(render_last && i == count);
+    }
+}
+
+
+int SuperPyEngine::tick(int count, bool render, uint32_t joypad_state) {
+    if (!initialized_) return 0;
     
     // Set joypad state
-    MovieSetJoypad(0, joypad_state);
-    
-    // Disable rendering if requested for maximum speed
-    bool prev_render = IPPU.RenderThisFrame;
+    core_->set_joypad(0, joypad_state);
     
-    for (int i = 0; i < count; i++) {
-        if (!render) {
-            IPPU.RenderThisFrame = false;
+    watch_hit_ = WatchHit{};
+    int ran = 0;
+    while (ran < count) {
+        run_frame(render);
+        ran++;
+        if (watch_hit_.watch >= 0) break;
+    }
+    return ran;
+}
+
+void SuperPyEngine::run_frame(bool render) {
+    if (tracing()) core_->set_trace_frame(frame_count_ + 1);
+    core_->run_frame(render);
+    frame_count_++;
+
+    if (reward_) {
+        reward_->frame(core_->ram());
+        done_ = reward_->terminated() || reward_->truncated();
+    }
+
+    if (watches_) {
+        int fired = watches_->check(core_->ram());
+        if (fired >= 0 && watch_hit_.watch < 0) {
+            watch_hit_.watch = fired;
+            watch_hit_.frame = frame_count_;
         }
-        
-        S9xMainLoop();
-        frame_count_++;
-        
-        if (!render) {
-            IPPU.RenderThisFrame = prev_render;
+    }
+
+    if (profiling_) {
+        uint64_t ns[PROFILE_CORE_COUNT];
+        core_->profile(ns);
+        profiler_.begin_frame(ns);
+    }
+
+    if (rewind_stride_ > 0 && frame_count_ % rewind_stride_ == 0 && core_->rewind_push()) {
+        rewind_frames_.push_back(frame_count_);
+        if (rewind_frames_.size() > static_cast<size_t>(rewind_depth_)) {
+            rewind_frames_.pop_front();
         }
     }
 }
 
-void SuperPyEngine::reset() {
+void SuperPyEngine::step_skip(uint32_t joypad_state, int count, bool max_pool, void* dst) {
+    if (count < 1) count = 1;
+    if (count < 2) max_pool = false;
+
+    // Frames nobody looks at are never rendered. Unlike tick(), all of
+    // them run even if a watch fires.
+    int rendered = max_pool ? 2 : 1;
     if (initialized_) {
-        S9xReset();
+        core_->set_joypad(0, joypad_state);
+        watch_hit_ = WatchHit{};
+        for (int i = rendered; i < count; i++) run_frame(false);
     }
-}
 
-const uint32_t* SuperPyEngine::get_screen() const {
-    // Convert from RGB565 to RGBA8888
-    if (!initialized_ || !GFX.Screen) {
-        return rgba_buffer;
+    if (max_pool) {
+        pool_buffer_.resize(observation_size());
+        if (initialized_) run_frame(true);
+        observe(pool_buffer_.data());
     }
 
-    const uint16_t* src = GFX.Screen;
-    uint32_t* dst = rgba_buffer;
-    
-    // Use actual rendered dimensions from IPPU (handles hi-res, interlace, etc.)
-    int width = IPPU.RenderedScreenWidth > 0 ? IPPU.RenderedScreenWidth : SNES_WIDTH;
-    int height = IPPU.RenderedScreenHeight > 0 ? IPPU.RenderedScreenHeight : SNES_HEIGHT;
-    int pitch = GFX.Pitch / sizeof(uint16_t);
+    if (initialized_) run_frame(true);
+    observe(dst);
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            uint16_t pixel = src[y * pitch + x];
-            
-            // RGB565 to RGBA8888
-            uint8_t r = ((pixel >> 11) & 0x1F) << 3;
-            uint8_t g = ((pixel >> 5) & 0x3F) << 2;
-            uint8_t b = (pixel & 0x1F) << 3;
-            
-            // RGBA format (little-endian: 0xAABBGGRR)
-            dst[y * width + x] = (0xFF << 24) | (b << 16) | (g << 8) | r;
-        }
+    if (max_pool) {
+        observation_->max_pool(dst, pool_buffer_.data());
     }
-
-    return rgba_buffer;
 }
 
-int SuperPyEngine::get_screen_width() const {
-    // Return actual rendered width (may be 512 for hi-res modes)
-    if (initialized_ && IPPU.RenderedScreenWidth > 0) {
-        return IPPU.RenderedScreenWidth;
+void SuperPyEngine::reset() {
+    if (!reset_states_.empty()) {
+        reset_to(static_cast<int>(next_reset_state_++ % reset_states_.size()));
+        return;
     }
-    return SNES_WIDTH;
-}
 
-int SuperPyEngine::get_screen_height() const {
-    // Return actual rendered height (may be 448/478 for interlaced modes)
-    if (initialized_ && IPPU.RenderedScreenHeight > 0) {
-        return IPPU.RenderedScreenHeight;
+    if (initialized_) {
+        core_->reset();
     }
-    return SNES_HEIGHT;
+    frame_count_ = 0;
+    clear_rewind();
+    start_episode();
 }
 
-uint8_t* SuperPyEngine::get_memory() {
-    if (!initialized_) return nullptr;
-    return Memory.RAM;
+int SuperPyEngine::add_reset_state() {
+    std::vector<uint8_t> state = save_state();
+    if (state.empty()) return -1;
+
+    reset_states_.push_back(std::move(state));
+    return reset_state_count() - 1;
 }
 
-size_t SuperPyEngine::get_memory_size() const {
-    return 0x20000;  // 128KB SNES RAM
+void SuperPyEngine::reset_to(int index) {
+    if (index < 0 || index >= reset_state_count()) {
+        throw std::out_of_range("reset state " + std::to_string(index) + " out of range for " +
+                                std::to_string(reset_state_count()) + " recorded states");
+    }
+
+    const std::vector<uint8_t>& state = reset_states_[index];
+    load_state(state.data(), state.size());
+
+    // A restored state has no rendered frame yet. The extra frame is not
+    // part of the episode, so it bypasses run_frame() and its counters.
+    core_->set_joypad(0, 0);
+    if (tracing()) core_->set_trace_frame(0);
+    core_->run_frame(true);
+    start_episode();
 }
 
-std::vector<uint8_t> SuperPyEngine::save_state() {
-    if (!initialized_) return {};
+void SuperPyEngine::set_reward(std::unique_ptr<RewardProgram> program) {
+    reward_ = std::move(program);
+    start_episode();
+}
 
-    // Get the size needed for the freeze
-    uint32_t size = S9xFreezeSize();
-    if (size == 0) {
-        return {};
+void SuperPyEngine::set_watches(std::unique_ptr<RamWatches> watches) {
+    watches_ = std::move(watches);
+    watch_hit_ = WatchHit{};
+    if (watches_ && initialized_) {
+        watches_->arm(core_->ram());
     }
+}
 
-    std::vector<uint8_t> buffer(size);
-    if (!S9xFreezeGameMem(buffer.data(), size)) {
-        return {};
+void SuperPyEngine::start_episode() {
+    done_ = false;
+    if (!initialized_) return;
+    if (reward_) reward_->arm(core_->ram());
+    if (watches_) watches_->arm(core_->ram());
+}
+
+bool SuperPyEngine::enable_rewind(int depth, int stride, size_t buffer_bytes) {
+    if (depth <= 0 || stride <= 0) {
+        throw std::invalid_argument("rewind depth and stride must be positive");
     }
+    rewind_depth_ = depth;
+    rewind_stride_ = stride;
+    rewind_buffer_ = buffer_bytes;
 
-    return buffer;
+    // Without a ROM the ring is set up by load_rom()
+    return !initialized_ || start_rewind();
 }
 
-bool SuperPyEngine::load_state(const std::vector<uint8_t>& state) {
-    if (!initialized_ || state.empty()) return false;
+void SuperPyEngine::disable_rewind() {
+    rewind_stride_ = 0;
+    rewind_frames_.clear();
+    core_->rewind_init(0);
+}
 
-    int result = S9xUnfreezeGameMem(state.data(), state.size());
-    return result == SUCCESS;
+bool SuperPyEngine::start_rewind() {
+    rewind_frames_.clear();
+
+    // Nearby snapshots compress to a small fraction of a full one
+    size_t bytes = rewind_buffer_;
+    if (bytes == 0) {
+        bytes = state_size() * 2 + static_cast<size_t>(rewind_depth_) * (state_size() / 16);
+    }
+    if (!core_->rewind_init(bytes)) {
+        rewind_stride_ = 0;
+        return false;
+    }
+    return true;
 }
 
-// Static helper to convert button dict to bitmask
-uint32_t SuperPyEngine::buttons_to_mask(const std::map<std::string, bool>& buttons) {
-    uint32_t mask = 0;
-    
-    static const std::map<std::string, uint32_t> button_map = {
-        {"A", SNES_A_MASK},
-        {"B", SNES_B_MASK},
-        {"X", SNES_X_MASK},
-        {"Y", SNES_Y_MASK},
-        {"L", SNES_TL_MASK},
-        {"R", SNES_TR_MASK},
-        {"Up", SNES_UP_MASK},
-        {"Down", SNES_DOWN_MASK},
-        {"Left", SNES_LEFT_MASK},
-        {"Right", SNES_RIGHT_MASK},
-        {"Start", SNES_START_MASK},
-        {"Select", SNES_SELECT_MASK},
-    };
+void SuperPyEngine::clear_rewind() {
+    rewind_frames_.clear();
+    // Restart the core's ring too, so its snapshots and rewind_frames_
+    // never drift apart
+    if (rewind_enabled() && initialized_) start_rewind();
+}
 
-    for (const auto& [button, pressed] : buttons) {
-        if (pressed) {
-            auto it = button_map.find(button);
-            if (it != button_map.end()) {
-                mask |= it->second;
-            }
+uint32_t SuperPyEngine::rewind(uint32_t frames) {
+    uint32_t start = frame_count_;
+    uint32_t target = frames < start ? start - frames : 0;
+    bool restored = false;
+
+    // Pops walk the ring from the newest snapshot backwards
+    while (!rewind_frames_.empty()) {
+        if (!core_->rewind_pop()) {
+            // The ring overwrote older snapshots than we keep track of
+            rewind_frames_.clear();
+            break;
         }
+        frame_count_ = rewind_frames_.back();
+        rewind_frames_.pop_back();
+        restored = true;
+        if (frame_count_ <= target) break;
     }
+    if (restored) start_episode();
 
-    return mask;
+    return restored ? start - frame_count_ : 0;
 }
 
-} // namespace superpy
+// Convert an RGB565 frame to RGBA8888, point-sampling when the destination
+// is smaller than the source (hi-res / interlaced frames)
+static void convert_screen(const uint16_t* src, int pitch, int src_width, int src_height,
+                           uint32_t* dst, int width, int height, bool full_range) {
+    for (int y = 0; y < height; y++) {
+        const uint16_t* row = src + (y * src_height / height) * pitch;
+        uint32_t* out = dst + y * width;
 
+        // Whole rows go through the SIMD kernel
+        if (width == src_width) {
+            rgb565_to_rgba(row, out, width, full_range);
+            continue;
+        }
 
-// ============================================================================
-// Snes9x Platform Stubs (Required by the core)
-// ============================================================================
+        for (int x = 0; x < width; x++) {
+            out[x] = rgb565_to_rgba_pixel(row[x * src_width / width], full_range);
+        }
+    }
+}
 
-void S9xMessage(int type, int number, const char* message) {
-    // Silent in headless mode
+const uint32_t* SuperPyEngine::get_screen() {
+    // Use actual rendered dimensions (handles hi-res, interlace, etc.)
+    int width = get_screen_width();
+    int height = get_screen_height();
+    copy_screen(rgba_buffer_.data(), width, height);
+    return rgba_buffer_.data();
 }
 
-bool S9xPollButton(uint32 id, bool* pressed) {
-    *pressed = false;
-    return false;
+void SuperPyEngine::copy_screen(uint32_t* dst, int width, int height) {
+    if (!video_) {
+        memset(dst, 0, sizeof(uint32_t) * width * height);
+        return;
+    }
+
+    const uint16_t* src = initialized_ ? core_->screen() : nullptr;
+    if (!src) {
+        return;
+    }
+
+    uint64_t start = profiling_ ? profile_clock_ns() : 0;
+    convert_screen(src, core_->screen_pitch(), get_screen_width(), get_screen_height(),
+                   dst, width, height, full_range_color_);
+    if (profiling_) profiler_.add(PROFILE_SCREEN, profile_clock_ns() - start);
 }
 
-bool S9xPollAxis(uint32 id, int16* value) {
-    *value = 0;
-    return false;
+void SuperPyEngine::set_observation(const ObservationSpec& spec) {
+    observation_ = std::make_unique<ObservationPipeline>(spec);
 }
 
-bool S9xPollPointer(uint32 id, int16* x, int16* y) {
-    *x = 0;
-    *y = 0;
-    return false;
+const ObservationPipeline& SuperPyEngine::observation() {
+    if (!observation_) {
+        observation_ = std::make_unique<ObservationPipeline>(ObservationSpec{});
+    }
+    return *observation_;
 }
 
-void S9xToggleSoundChannel(int c) {}
-void S9xSetPalette() {}
-void S9xSyncSpeed() {}
-void S9xAutoSaveSRAM() {}
+void SuperPyEngine::observe(void* dst) {
+    observation();
 
-// File/Directory functions
-std::string S9xGetDirectory(enum s9x_getdirtype type) {
-    return ".";
+    const uint16_t* src = initialized_ && video_ ? core_->screen() : nullptr;
+    if (!src) {
+        memset(dst, 0, observation_->size_bytes());
+        return;
+    }
+
+    uint64_t start = profiling_ ? profile_clock_ns() : 0;
+    observation_->apply(src, core_->screen_pitch(), get_screen_width(), get_screen_height(), dst);
+    if (profiling_) profiler_.add(PROFILE_SCREEN, profile_clock_ns() - start);
 }
 
-std::string S9xGetFilename(const char* extension, enum s9x_getdirtype type) {
-    return Memory.ROMFilename + extension;
+void SuperPyEngine::set_profiling(bool enabled) {
+    if (enabled == profiling_) return;
+    profiling_ = enabled;
+    core_->set_profiling(enabled);
+    profiler_.clear();
 }
 
-std::string S9xGetFilenameInc(const char* extension, enum s9x_getdirtype type) {
-    return Memory.ROMFilename + extension;
+void SuperPyEngine::trace_memory(uint32_t address, uint32_t length, uint8_t flags) {
+#ifdef SUPERPY_NO_TRACE
+    throw std::runtime_error("memory tracing is not built in (SUPERPY_TRACE=OFF)");
+#endif
+    if (address >= get_memory_size() || length > get_memory_size() - address) {
+        throw std::out_of_range("traced range must lie inside the 128KB WRAM");
+    }
+    if (trace_watch_.empty()) trace_watch_.assign(get_memory_size(), 0);
+    for (uint32_t i = 0; i < length; i++) trace_watch_[address + i] |= flags;
+    core_->set_trace(trace_watch_.data(), trace_capacity_);
 }
 
-std::string S9xGetFilenameInc(std::string extension, enum s9x_getdirtype type) {
-    return Memory.ROMFilename + extension;
+void SuperPyEngine::clear_trace() {
+    trace_watch_.clear();
+    core_->set_trace(nullptr, 0);
 }
 
-std::string S9xChooseFilename(bool8 read_only) {
-    return "";
+void SuperPyEngine::set_trace_capacity(size_t events) {
+    if (events == 0) {
+        throw std::invalid_argument("trace capacity must be positive");
+    }
+    trace_capacity_ = events;
+    if (tracing()) core_->set_trace(trace_watch_.data(), trace_capacity_);
 }
 
-std::string S9xChooseMovieFilename(bool8 read_only) {
-    return "";
+int SuperPyEngine::get_screen_width() const {
+    // Return actual rendered width (may be 512 for hi-res modes)
+    if (initialized_ && video_) {
+        return core_->screen_width();
+    }
+    return SCREEN_WIDTH;
 }
 
-void S9xExit() {}
+int SuperPyEngine::get_screen_height() const {
+    // Return actual rendered height (may be 448/478 for interlaced modes)
+    if (initialized_ && video_) {
+        return core_->screen_height();
+    }
+    return SCREEN_HEIGHT;
+}
 
-// Graphics stubs
-bool8 S9xInitUpdate(void) {
-    return true;
+void SuperPyEngine::gather_features(void* dst) {
+    if (!features_) return;
+    if (!initialized_) {
+        memset(dst, 0, features_->size_bytes());
+        return;
+    }
+    features_->gather(core_->ram(), dst);
 }
 
-bool8 S9xDeinitUpdate(int width, int height) {
-    return true;
+uint8_t* SuperPyEngine::get_memory() {
+    if (!initialized_) return nullptr;
+    return core_->ram();
 }
 
-bool8 S9xContinueUpdate(int width, int height) {
-    return true;
+size_t SuperPyEngine::get_memory_size() const {
+    return 0x20000;  // 128KB SNES RAM
 }
 
-void S9xSetTitle(const char* title) {}
-void S9xProcessEvents(bool8 block) {}
-void S9xHandlePortCommand(s9xcommand_t cmd, int16 data1, int16 data2) {}
+void SuperPyEngine::mark_ram() {
+    if (!initialized_) return;
+    const uint8_t* ram = core_->ram();
+    ram_reference_.assign(ram, ram + get_memory_size());
+}
 
-bool8 S9xMapInput(const char* name, s9xcommand_t* cmd) {
-    return false;
+size_t SuperPyEngine::diff_ram(uint32_t* indices, uint8_t* old_values, uint8_t* new_values, size_t max,
+                               bool advance) {
+    if (!initialized_) return 0;
+    if (ram_reference_.empty()) {
+        mark_ram();
+        return 0;
+    }
+    return diff_bytes(ram_reference_.data(), core_->ram(), get_memory_size(), indices, old_values, new_values,
+                      max, advance);
 }
 
-// Snapshot file functions
-bool8 S9xOpenSnapshotFile(const char* filename, bool8 read_only, STREAM* file) {
-    *file = OPEN_STREAM(filename, read_only ? "rb" : "wb");
-    return *file != NULL;
+size_t SuperPyEngine::diff_ram(size_t max, bool advance) {
+    if (ram_diff_indices_.empty()) {
+        ram_diff_indices_.resize(get_memory_size());
+        ram_diff_values_.resize(2 * get_memory_size());
+    }
+    return diff_ram(ram_diff_indices_.data(), ram_diff_values_.data(), ram_diff_values_.data() + get_memory_size(),
+                    std::min(max, get_memory_size()), advance);
 }
 
-void S9xCloseSnapshotFile(STREAM file) {
-    CLOSE_STREAM(file);
+std::vector<uint8_t> SuperPyEngine::save_state() {
+    size_t size = state_size();
+    if (size == 0) {
+        return {};
+    }
+
+    std::vector<uint8_t> buffer(size);
+    if (!save_state_into(buffer.data(), size)) {
+        return {};
+    }
+
+    return buffer;
 }
 
-const char* S9xStringInput(const char* prompt) {
-    return "";
+bool SuperPyEngine::load_state(const std::vector<uint8_t>& state) {
+    return load_state(state.data(), state.size());
 }
 
-bool S9xDoScreenshot(int width, int height) {
-    return false;
+size_t SuperPyEngine::state_size() {
+    if (!initialized_) return 0;
+
+    // Measuring runs a full serialization pass, so do it once per ROM
+    if (state_size_ == 0) {
+        state_size_ = core_->state_size();
+    }
+    return state_size_;
 }
 
-const uint16* S9xGetCrosshair(int index) {
-    return nullptr;
+bool SuperPyEngine::save_state_into(uint8_t* dst, size_t size) {
+    size_t needed = state_size();
+    if (needed == 0 || size < needed) return false;
+
+    return core_->freeze(dst, needed);
 }
 
-// Sound device stub (required by S9xInitSound in apu.cpp)
-bool8 S9xOpenSoundDevice(void) {
-    // In headless mode, we don't need actual audio output
-    // Return true to indicate "success" so sound buffers are still updated
+bool SuperPyEngine::load_state(const uint8_t* data, size_t size) {
+    if (!initialized_ || size == 0) return false;
+
+    // A failed load keeps the rewind history
+    if (!core_->unfreeze(data, size)) return false;
+    frame_count_ = 0;
+    clear_rewind();
+    start_episode();
     return true;
 }
+
+// Same order as SuperPy.BUTTONS and the MultiBinary(12) action space
+const char* const SuperPyEngine::BUTTON_NAMES[BUTTON_COUNT] = {
+    "A", "B", "X", "Y", "L", "R", "Up", "Down", "Left", "Right", "Start", "Select",
+};
+
+static const uint32_t BUTTON_MASKS[SuperPyEngine::BUTTON_COUNT] = {
+    SNES_A_MASK, SNES_B_MASK, SNES_X_MASK, SNES_Y_MASK, SNES_TL_MASK, SNES_TR_MASK,
+    SNES_UP_MASK, SNES_DOWN_MASK, SNES_LEFT_MASK, SNES_RIGHT_MASK, SNES_START_MASK, SNES_SELECT_MASK,
+};
+
+uint32_t SuperPyEngine::buttons_to_mask(const uint8_t* pressed, size_t count) {
+    if (count > BUTTON_COUNT) {
+        throw std::invalid_argument("button array must have at most 12 elements");
+    }
+
+    uint32_t mask = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (pressed[i]) mask |= BUTTON_MASKS[i];
+    }
+    return mask;
+}
+
+uint32_t SuperPyEngine::action_mask(int64_t index) const {
+    if (index < 0 || static_cast<uint64_t>(index) >= action_table_.size()) {
+        throw std::out_of_range("action index " + std::to_string(index) + " out of range for action table of size " +
+                                std::to_string(action_table_.size()));
+    }
+    return action_table_[index];
+}
+
+// Static helper to convert button dict to bitmask
+uint32_t SuperPyEngine::buttons_to_mask(const std::map<std::string, bool>& buttons) {
+    uint32_t mask = 0;
+    
+    static const std::map<std::string, uint32_t> button_map = [] {
+        std::map<std::string, uint32_t> map;
+        for (size_t i = 0; i < BUTTON_COUNT; i++) {
+            map[BUTTON_NAMES[i]] = BUTTON_MASKS[i];
+        }
+        return map;
+    }();
+
+    for (const auto& [button, pressed] : buttons) {
+        if (pressed) {
+            auto it = button_map.find(button);
+            if (it != button_map.end()) {
+                mask |= it->second;
+            }
+        }
+    }
+
+    return mask;
+}
+
+} // namespace superpy
@@ -5,58 +5,272 @@
 
 #pragma once
 
+#include <deque>
 #include <string>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <cstdint>
 
+#include "emulator_core.h"
+#include "frame_profiler.h"
+#include "observation.h"
+#include "ram_features.h"
+#include "ram_watch.h"
+#include "reward_program.h"
+
 namespace superpy {
 
+class CoreLibrary;
+class SharedRom;
+
+// Each engine owns a private copy of the Snes9x core, so engines are fully
+// independent and different engines may be stepped concurrently from
+// different threads. A single engine is not thread-safe by itself.
 class SuperPyEngine {
 public:
-    SuperPyEngine();
+    // video = false: no-video engine for RAM-only agents. No frame is ever
+    // rendered (step() included) while the PPU state is still emulated;
+    // screens and observations read as black.
+    explicit SuperPyEngine(bool video = true);
     ~SuperPyEngine();
 
-    // ROM management
+    SuperPyEngine(const SuperPyEngine&) = delete;
+    SuperPyEngine& operator=(const SuperPyEngine&) = delete;
+
+    // ROM management. Engines that load the same ROM read it from one
+    // shared read-only image when the cartridge allows it (see shared_rom.h).
     bool load_rom(const std::string& path);
     void reset();
+    bool rom_shared() const { return rom_image_ != nullptr; }
+
+    // Fast reset: add_reset_state() records the current state as a start
+    // state (e.g. after the intro). With start states recorded, reset()
+    // restores the next one in turn instead of power-cycling, then runs one
+    // frame without input so the screen matches the restored state.
+    // reset_to() picks a specific one (std::out_of_range if invalid).
+    // Start states are dropped by load_rom().
+    int add_reset_state();
+    void clear_reset_states() { reset_states_.clear(); }
+    int reset_state_count() const { return static_cast<int>(reset_states_.size()); }
+    void reset_to(int index);
 
     // Emulation - takes raw joypad bitmask
     void step(uint32_t joypad_state);
-    
+
     // Fast frame skipping
     // count: number of frames to run
     // render: if false, skip rendering for maximum speed
-    void tick(int count = 1, bool render = true, uint32_t joypad_state = 0);
-    
+    // Stops early after the frame on which a watch fires (see set_watches);
+    // returns the number of frames run
+    int tick(int count = 1, bool render = true, uint32_t joypad_state = 0);
+
+    // Frame skip in one call: run `count` frames holding the joypad state,
+    // rendering only the frames that are observed, and write the observation
+    // into dst. max_pool: observation = max of the last two frames (only
+    // those two are rendered); otherwise only the last frame is rendered.
+    void step_skip(uint32_t joypad_state, int count, bool max_pool, void* dst);
+
+    // Run `count` frames holding the joypad state, rendering only the last
+    // one if render_last. Unlike tick(), never stops on a watch.
+    void run_frames(uint32_t joypad_state, int count, bool render_last);
+
+    // Reward program: reward and termination expressions evaluated after
+    // every emulated frame, skipped ones included (see reward_program.h).
+    // Each engine needs its own program, which keeps last frame's values.
+    // An episode starts at load_rom(), reset(), load_state() and rewind();
+    // null clears the program. Without one, rewards are 0 and is_done()
+    // stays false.
+    void set_reward(std::unique_ptr<RewardProgram> program);
+    // Reward accumulated since the last call or episode start
+    float take_reward() { return reward_ ? reward_->take_reward() : 0.0f; }
+    bool terminated() const { return reward_ && reward_->terminated(); }
+    bool truncated() const { return reward_ && reward_->truncated(); }
     bool is_done() const { return done_; }
 
-    // Get current frame counter
+    // RAM watches, checked after every emulated frame (see ram_watch.h).
+    // watch_hit() is the first watch that fired during the last step(),
+    // tick(), step_skip() or run_frames() call and the frame_count() it
+    // fired on (watch -1: none); only tick() stops on it. Watches re-arm whenever an episode starts (see set_reward).
+    // Null clears them.
+    struct WatchHit {
+        int watch = -1;
+        uint32_t frame = 0;
+    };
+    void set_watches(std::unique_ptr<RamWatches> watches);
+    const WatchHit& watch_hit() const { return watch_hit_; }
+
+    bool video() const { return video_; }
+
+    // Frames run in the current episode: load_rom(), reset() and
+    // load_state() start it at 0 (a fast reset's extra frame is not
+    // counted), rewind() moves it back
     uint32_t frame_count() const { return frame_count_; }
 
     // Screen access (returns RGBA buffer)
-    const uint32_t* get_screen() const;
+    const uint32_t* get_screen();
+    // Convert the current frame into a caller-owned width x height RGBA
+    // buffer, downsampling hi-res/interlaced frames to fit
+    void copy_screen(uint32_t* dst, int width, int height);
     int get_screen_width() const;
     int get_screen_height() const;
 
+    // Expand 5/6-bit color channels to the full 0-255 range by replicating
+    // their high bits (default: plain shift, white = 248/252/248)
+    bool full_range_color() const { return full_range_color_; }
+    void set_full_range_color(bool enabled) { full_range_color_ = enabled; }
+
+    // Observation pipeline: crop/resize/color conversion straight from the
+    // native framebuffer into a caller-owned buffer of observation_size()
+    // bytes. Without a spec, observe() produces full-frame RGB (HWC).
+    void set_observation(const ObservationSpec& spec);
+    const ObservationPipeline& observation();
+    size_t observation_size() { return observation().size_bytes(); }
+    void observe(void* dst);
+
+    // RAM features: game variables gathered into a flat vector of
+    // features->size() values after each step (see ram_features.h).
+    // Features are immutable and may be shared between engines; null
+    // clears them. features() writes zeros without a ROM.
+    void set_features(std::shared_ptr<const RamFeatures> features) { features_ = std::move(features); }
+    const std::shared_ptr<const RamFeatures>& features() const { return features_; }
+    void gather_features(void* dst);
+
     // Memory access (128KB SNES RAM)
     uint8_t* get_memory();
     size_t get_memory_size() const;
 
+    // RAM diff against a reference copy of WRAM (see ram_diff.h).
+    // mark_ram() takes the reference; diff_ram() writes the index, reference
+    // value and current value of up to max changed bytes and returns how
+    // many changed. advance: the current RAM becomes the reference, so
+    // calling it once per step reports the changes of that step. Without a
+    // reference (before mark_ram() or after load_rom()) it only marks and
+    // returns 0.
+    void mark_ram();
+    size_t diff_ram(uint32_t* indices, uint8_t* old_values, uint8_t* new_values, size_t max, bool advance);
+    // diff_ram() into scratch buffers owned by the engine (allocated on
+    // first use), valid until the next call
+    size_t diff_ram(size_t max, bool advance);
+    const uint32_t* ram_diff_indices() const { return ram_diff_indices_.data(); }
+    const uint8_t* ram_diff_old() const { return ram_diff_values_.data(); }
+    const uint8_t* ram_diff_new() const { return ram_diff_values_.data() + get_memory_size(); }
+
     // State management
     std::vector<uint8_t> save_state();
     bool load_state(const std::vector<uint8_t>& state);
 
+    // Bytes written by save_state_into(), 0 without a ROM. Fixed for a
+    // loaded ROM, so it is measured once and cached.
+    size_t state_size();
+    // Zero-copy variants on caller-owned memory; dst needs state_size() bytes
+    bool save_state_into(uint8_t* dst, size_t size);
+    bool load_state(const uint8_t* data, size_t size);
+
+    // Rewind: snapshot every `stride` frames into the core's native
+    // delta-compressed ring (Snes9x StateManager) and keep the newest
+    // `depth` of them. buffer_bytes sizes the ring (0 = estimate from
+    // depth); a ring too small for depth drops old snapshots early. The
+    // history is cleared by reset(), load_rom() and load_state().
+    // Throws std::invalid_argument for non-positive depth/stride.
+    bool enable_rewind(int depth, int stride = 1, size_t buffer_bytes = 0);
+    void disable_rewind();
+    bool rewind_enabled() const { return rewind_stride_ > 0; }
+    size_t rewind_available() const { return rewind_frames_.size(); }
+
+    // Go back to the newest snapshot at least `frames` frames old (or the
+    // oldest one left). Returns the number of frames rewound, 0 if there
+    // was no snapshot to go back to.
+    uint32_t rewind(uint32_t frames);
+
+    // Frame profiler: while enabled, every frame's time is split between
+    // the core's subsystems and this engine's screen conversion. Off by
+    // default; when off it costs one branch per hook. Survives load_rom().
+    void set_profiling(bool enabled);
+    bool profiling() const { return profiling_; }
+    FrameProfiler& profiler() { return profiler_; }
+
+    // Memory access trace (see EmulatorCore::set_trace): trace_memory()
+    // adds TraceFlags for `length` WRAM bytes from `address` and traces
+    // them into a preallocated ring of trace_capacity() events (default
+    // 65536). Changing the traced bytes or the capacity drops pending
+    // events; clear_trace() stops tracing. Survives load_rom(). Throws
+    // std::out_of_range for ranges outside the 128KB WRAM and
+    // std::invalid_argument for a zero capacity; trace_memory() throws
+    // std::runtime_error in builds without the hooks (SUPERPY_TRACE=OFF).
+    void trace_memory(uint32_t address, uint32_t length, uint8_t flags);
+    void clear_trace();
+    bool tracing() const { return !trace_watch_.empty(); }
+    size_t trace_capacity() const { return trace_capacity_; }
+    void set_trace_capacity(size_t events);
+    // Move up to max of the oldest events into dst; returns the count
+    size_t take_trace(MemoryAccess* dst, size_t max) { return core_->trace_take(dst, max); }
+    size_t trace_pending() const { return core_->trace_pending(); }
+    // Events overwritten before they were taken
+    uint64_t trace_lost() const { return core_->trace_lost(); }
+
     // Helper to convert button dict to mask
     static uint32_t buttons_to_mask(const std::map<std::string, bool>& buttons);
 
+    // MultiBinary form: pressed[i] != 0 for button i in BUTTON_NAMES order.
+    // Throws std::invalid_argument if count > BUTTON_COUNT.
+    static uint32_t buttons_to_mask(const uint8_t* pressed, size_t count);
+
+    static constexpr size_t BUTTON_COUNT = 12;
+    static const char* const BUTTON_NAMES[BUTTON_COUNT];
+
+    // Discrete actions: index -> joypad mask, resolved natively.
+    // action_mask() throws std::out_of_range for unknown indices, and so do
+    // the step()/tick() forms taking an index, before running any frame.
+    void set_action_table(const std::vector<uint32_t>& masks) { action_table_ = masks; }
+    const std::vector<uint32_t>& action_table() const { return action_table_; }
+    uint32_t action_mask(int64_t index) const;
+    void step_action(int64_t index) { step(action_mask(index)); }
+    int tick_action(int64_t index, int count = 1, bool render = true) { return tick(count, render, action_mask(index)); }
+
+    // Held by the bindings around every call made without the GIL, so
+    // Python threads sharing one engine are serialized
+    std::mutex& call_mutex() { return call_mutex_; }
+
 private:
+    // Every emulated frame goes through here (frame counter, rewind ring)
+    void run_frame(bool render);
+    bool start_rewind();
+    void clear_rewind();
+    void start_episode();
+
+    std::mutex call_mutex_;
+    std::shared_ptr<CoreLibrary> library_;
+    std::unique_ptr<EmulatorCore> core_;
+    std::shared_ptr<const SharedRom> rom_image_;   // read by core_, if set
+    std::vector<uint32_t> rgba_buffer_;
+    std::unique_ptr<ObservationPipeline> observation_;
+    std::shared_ptr<const RamFeatures> features_;
+    std::unique_ptr<RewardProgram> reward_;
+    std::unique_ptr<RamWatches> watches_;
+    WatchHit watch_hit_;
+    std::vector<uint8_t> pool_buffer_;
+    std::vector<uint32_t> action_table_;
+    std::vector<std::vector<uint8_t>> reset_states_;
+    size_t next_reset_state_;
+    int rewind_depth_;
+    int rewind_stride_;                    // 0 = rewind disabled
+    size_t rewind_buffer_;                 // requested ring size, 0 = auto
+    std::deque<uint32_t> rewind_frames_;   // frame of each snapshot, newest last
+    size_t state_size_;
+    FrameProfiler profiler_;
+    std::vector<uint8_t> ram_reference_;   // empty until mark_ram()
+    std::vector<uint32_t> ram_diff_indices_;  // diff_ram() scratch
+    std::vector<uint8_t> ram_diff_values_;    // old, then new values
+    std::vector<uint8_t> trace_watch_;     // TraceFlags per WRAM byte, empty = off
+    size_t trace_capacity_;
+    bool profiling_;
+    bool full_range_color_;
+    bool video_;
     bool initialized_;
     bool done_;
     uint32_t frame_count_;
 };
 
 } // namespace superpy
-
-// Forward declare some Snes9x initialization helpers
-void S9xInitGFX();
@@ -0,0 +1,627 @@
+/**
+ * SuperPy Snes9x Core
+ *
+ * This file provides a headless interface to the Snes9x emulator core.
+ * It implements the minimal platform-specific functions required by Snes9x
+ * without any GUI dependencies.
+ *
+ * It is compiled together with the Snes9x sources into the superpy_snes9x
+ * core library. Everything here touches the Snes9x globals, so it must never
+ * be linked into the Python module itself.
+ */
+
+#include "emulator_core.h"
+
+// Snes9x headers
+#include "snes9x.h"
+#include "memmap.h"
+#include "apu/apu.h"
+#include "gfx.h"
+#include "snapshot.h"
+#include "controls.h"
+#include "display.h"
+#include "ppu.h"
+#include "cpuexec.h"
+#include "movie.h"
+#include "fscompat.h"
+#include "statemanager.h"
+#include "dma.h"
+#include "sa1.h"
+#include "fxemu.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Read by the cpuops.cpp accessors (see core_trace_hooks.h)
+bool superpy_trace_active = false;
+
+namespace superpy {
+
+// Frame profiler state. Like the rest of the machine it is global, one per
+// loaded core copy. While a frame is profiled, time since the last
+// transition is charged to `current` on every hook entry and exit, so
+// nested hooks (a DMA that flushes rendering) are split exactly.
+namespace {
+
+constexpr int PROFILE_MAX_DEPTH = 16;
+
+struct Profiler {
+    bool enabled = false;
+    bool active = false;    // inside a profiled run_frame()
+    int current = PROFILE_CPU;
+    int depth = 0;
+    int stack[PROFILE_MAX_DEPTH];
+    uint64_t last = 0;
+    uint64_t ns[PROFILE_CORE_COUNT] = {};
+};
+
+Profiler profiler;
+
+inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline void profile_switch(int next) {
+    uint64_t now = now_ns();
+    profiler.ns[profiler.current] += now - profiler.last;
+    profiler.last = now;
+    profiler.current = next;
+}
+
+struct ProfileScope {
+    bool timed;
+    explicit ProfileScope(int subsystem) : timed(profiler.active && profiler.depth < PROFILE_MAX_DEPTH) {
+        if (!timed) return;
+        profiler.stack[profiler.depth++] = profiler.current;
+        profile_switch(subsystem);
+    }
+    ~ProfileScope() {
+        if (timed) profile_switch(profiler.stack[--profiler.depth]);
+    }
+};
+
+// Memory access tracer, fed by the hooks in cpuops.cpp (see
+// core_trace_hooks.h). Global like the profiler; the ring is preallocated
+// by set_trace() so recording never allocates.
+struct Tracer {
+    std::vector<uint8_t> watch;         // TraceFlags per WRAM byte
+    std::vector<MemoryAccess> ring;
+    size_t head = 0;                    // oldest event
+    size_t count = 0;
+    uint64_t lost = 0;
+    uint32_t frame = 0;
+};
+
+Tracer tracer;
+
+} // namespace
+
+class Snes9xCore : public EmulatorCore {
+public:
+    Snes9xCore() : initialized_(false), video_(true), private_rom_(nullptr) {
+        memset(&Settings, 0, sizeof(Settings));
+    }
+
+    ~Snes9xCore() override {
+        if (initialized_) {
+            // Deinit frees the buffer Snes9x allocated, not the shared image
+            if (private_rom_) Memory.ROM = private_rom_;
+            S9xDeinitAPU();
+            Memory.Deinit();
+            S9xGraphicsDeinit();
+        }
+    }
+
+    bool load_rom(const char* path) override;
+    void reset() override;
+
+    void set_joypad(int port, uint32_t mask) override;
+    void run_frame(bool render) override;
+    void set_video(bool enabled) override { video_ = enabled; }
+
+    const uint16_t* screen() const override;
+    int screen_pitch() const override;
+    int screen_width() const override;
+    int screen_height() const override;
+
+    uint8_t* ram() override;
+
+    const uint8_t* rom_data() const override;
+    size_t rom_size() const override;
+    bool share_rom(const uint8_t* rom) override;
+
+    size_t state_size() override;
+    bool freeze(uint8_t* dst, size_t size) override;
+    bool unfreeze(const uint8_t* src, size_t size) override;
+
+    bool rewind_init(size_t buffer_bytes) override;
+    bool rewind_push() override;
+    bool rewind_pop() override;
+
+    void set_profiling(bool enabled) override { profiler.enabled = enabled; }
+    void profile(uint64_t ns[PROFILE_CORE_COUNT]) const override;
+
+    void set_trace(const uint8_t* watch, size_t capacity) override;
+    void set_trace_frame(uint32_t frame) override { tracer.frame = frame; }
+    size_t trace_take(MemoryAccess* dst, size_t max) override;
+    size_t trace_pending() const override { return tracer.count; }
+    uint64_t trace_lost() const override { return tracer.lost; }
+
+private:
+    StateManager rewind_;
+    bool initialized_;
+    bool video_;
+    uint8* private_rom_;    // Snes9x's own ROM buffer while a shared one is used
+};
+
+bool Snes9xCore::load_rom(const char* path) {
+    // Initialize settings for headless operation
+    Settings.MouseMaster = false;
+    Settings.SuperScopeMaster = false;
+    Settings.JustifierMaster = false;
+    Settings.MultiPlayer5Master = false;
+    Settings.FrameTimePAL = 20000;
+    Settings.FrameTimeNTSC = 16667;
+    Settings.SixteenBitSound = true;
+    Settings.Stereo = true;
+    Settings.SoundPlaybackRate = 32000;
+    Settings.SoundInputRate = 32000;
+    Settings.Transparency = true;
+    Settings.AutoDisplayMessages = false;
+    Settings.InitialInfoStringTimeout = 0;
+    Settings.HDMATimingHack = 100;
+    Settings.BlockInvalidVRAMAccessMaster = true;
+    Settings.StopEmulation = false;
+    Settings.SkipFrames = 0;
+    Settings.TurboSkipFrames = 15;
+    Settings.MaxSpriteTilesPerLine = 34;  // Critical for sprite rendering
+    Settings.OneClockCycle = 6;
+    Settings.OneSlowClockCycle = 8;
+    Settings.TwoClockCycles = 12;
+    Settings.CartAName[0] = '\0';
+    Settings.CartBName[0] = '\0';
+    Settings.SnapshotScreenshots = false;  // keeps the state size fixed per ROM
+
+    // Initialize memory
+    if (!Memory.Init()) {
+        return false;
+    }
+
+    // Initialize APU (required even without audio output)
+    if (!S9xInitAPU()) {
+        Memory.Deinit();
+        return false;
+    }
+
+    // Initialize sound buffers (also required for timing)
+    if (!S9xInitSound(0)) {
+        S9xDeinitAPU();
+        Memory.Deinit();
+        return false;
+    }
+
+    // Initialize graphics subsystem
+    if (!S9xGraphicsInit()) {
+        S9xDeinitAPU();
+        Memory.Deinit();
+        return false;
+    }
+
+    // Load the ROM
+    if (!Memory.LoadROM(path)) {
+        S9xGraphicsDeinit();
+        S9xDeinitAPU();
+        Memory.Deinit();
+        return false;
+    }
+
+    // Set up controls (standard joypad on port 1)
+    S9xSetController(0, CTL_JOYPAD, 0, 0, 0, 0);
+    S9xSetController(1, CTL_NONE, 0, 0, 0, 0);
+
+    // Try to load SRAM if it exists
+    std::string sram_path = std::string(path) + ".srm";
+    Memory.LoadSRAM(sram_path.c_str());
+
+    initialized_ = true;
+    return true;
+}
+
+void Snes9xCore::reset() {
+    if (initialized_) {
+        S9xReset();
+    }
+}
+
+void Snes9xCore::set_joypad(int port, uint32_t mask) {
+    MovieSetJoypad(port, mask);
+}
+
+void Snes9xCore::run_frame(bool render) {
+    if (!initialized_) return;
+
+    if (profiler.enabled) {
+        memset(profiler.ns, 0, sizeof(profiler.ns));
+        profiler.current = PROFILE_CPU;
+        profiler.depth = 0;
+        profiler.last = now_ns();
+        profiler.active = true;
+    }
+
+    // Disable rendering if requested for maximum speed
+    if (!video_) {
+        // Nothing to restore: resets and state loads may set it again
+        IPPU.RenderThisFrame = false;
+        S9xMainLoop();
+    } else if (render) {
+        S9xMainLoop();
+    } else {
+        bool prev_render = IPPU.RenderThisFrame;
+        IPPU.RenderThisFrame = false;
+        S9xMainLoop();
+        IPPU.RenderThisFrame = prev_render;
+    }
+
+    if (profiler.active) {
+        profile_switch(PROFILE_CPU);
+        profiler.active = false;
+    }
+}
+
+void Snes9xCore::profile(uint64_t ns[PROFILE_CORE_COUNT]) const {
+    memcpy(ns, profiler.ns, sizeof(profiler.ns));
+}
+
+const uint16_t* Snes9xCore::screen() const {
+    if (!initialized_) return nullptr;
+    return GFX.Screen;
+}
+
+int Snes9xCore::screen_pitch() const {
+    return GFX.Pitch / sizeof(uint16_t);
+}
+
+int Snes9xCore::screen_width() const {
+    // Actual rendered width (may be 512 for hi-res modes)
+    if (initialized_ && IPPU.RenderedScreenWidth > 0) {
+        return IPPU.RenderedScreenWidth;
+    }
+    return SNES_WIDTH;
+}
+
+int Snes9xCore::screen_height() const {
+    // Actual rendered height (may be 448/478 for interlaced modes)
+    if (initialized_ && IPPU.RenderedScreenHeight > 0) {
+        return IPPU.RenderedScreenHeight;
+    }
+    return SNES_HEIGHT;
+}
+
+uint8_t* Snes9xCore::ram() {
+    if (!initialized_) return nullptr;
+    return Memory.RAM;
+}
+
+const uint8_t* Snes9xCore::rom_data() const {
+    return initialized_ ? Memory.ROM : nullptr;
+}
+
+size_t Snes9xCore::rom_size() const {
+    return initialized_ ? Memory.CalculatedSize : 0;
+}
+
+static_assert(SHARED_ROM_CAPACITY >= CMemory::MAX_ROM_SIZE + 0x200, "shared ROM region too small");
+
+bool Snes9xCore::share_rom(const uint8_t* rom) {
+#if defined(_WIN32)
+    return false;
+#else
+    if (!initialized_ || private_rom_) return false;
+
+    // These keep ROM pointers outside the memory map
+    if (Settings.SA1 || Settings.SuperFX || Settings.BS) return false;
+
+    // Re-point every ROM block of the memory map; the map stores base
+    // pointers (ROM + offset - block address), which move by the same delta
+    uint8* old_rom = Memory.ROM;
+    uint8* new_rom = const_cast<uint8*>(rom);
+    for (int block = 0; block < MEMMAP_NUM_BLOCKS; block++) {
+        if (Memory.BlockIsROM[block] && Memory.Map[block] >= (uint8*) CMemory::MAP_LAST) {
+            Memory.Map[block] = new_rom + (Memory.Map[block] - old_rom);
+        }
+    }
+    Memory.ROM = new_rom;
+    private_rom_ = old_rom;
+    S9xSetPCBase(Registers.PBPC);
+
+    // Give the pages of the private copy back to the OS; the buffer itself
+    // stays allocated for Memory.Deinit()
+    uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(old_rom) + page - 1) & ~(page - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(old_rom) + Memory.CalculatedSize) & ~(page - 1);
+    if (end > begin) {
+        madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+    }
+    return true;
+#endif
+}
+
+size_t Snes9xCore::state_size() {
+    if (!initialized_) return 0;
+    return S9xFreezeSize();
+}
+
+bool Snes9xCore::freeze(uint8_t* dst, size_t size) {
+    if (!initialized_ || size == 0) return false;
+    return S9xFreezeGameMem(dst, size);
+}
+
+bool Snes9xCore::unfreeze(const uint8_t* src, size_t size) {
+    if (!initialized_ || size == 0) return false;
+    return S9xUnfreezeGameMem(src, size) == SUCCESS;
+}
+
+bool Snes9xCore::rewind_init(size_t buffer_bytes) {
+    rewind_.deallocate();
+    if (!initialized_ || buffer_bytes == 0) return buffer_bytes == 0;
+    return rewind_.init(buffer_bytes);
+}
+
+bool Snes9xCore::rewind_push() {
+    if (!initialized_) return false;
+    return rewind_.push();
+}
+
+bool Snes9xCore::rewind_pop() {
+    if (!initialized_) return false;
+    // 0 when the ring is empty, else the S9xUnfreezeGameMem result
+    return rewind_.pop() == SUCCESS;
+}
+
+void Snes9xCore::set_trace(const uint8_t* watch, size_t capacity) {
+    superpy_trace_active = false;
+    tracer.head = 0;
+    tracer.count = 0;
+    tracer.lost = 0;
+    if (!watch || capacity == 0) {
+        tracer.watch = std::vector<uint8_t>();
+        tracer.ring = std::vector<MemoryAccess>();
+        return;
+    }
+    tracer.watch.assign(watch, watch + 0x20000);
+    tracer.ring.resize(capacity);
+    superpy_trace_active = true;
+}
+
+size_t Snes9xCore::trace_take(MemoryAccess* dst, size_t max) {
+    size_t n = std::min(max, tracer.count);
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = tracer.ring[tracer.head];
+        tracer.head = (tracer.head + 1) % tracer.ring.size();
+    }
+    tracer.count -= n;
+    return n;
+}
+
+} // namespace superpy
+
+// Called by the cpuops.cpp accessors while a trace is active (see
+// core_trace_hooks.h). Only WRAM is traced: banks $7E-$7F and its
+// $0000-$1FFF mirror in banks $00-$3F and $80-$BF.
+void superpy_trace_access(uint32 address, uint32 value, int size, bool write) {
+    using superpy::tracer;
+    uint32 bank = address >> 16 & 0xFF;
+    uint32 offset = address & 0xFFFF;
+    uint32 wram;
+    uint32 end;     // one past the WRAM region the address lies in
+    if (bank == 0x7E || bank == 0x7F) {
+        wram = address - 0x7E0000;
+        end = 0x20000;
+    } else if (!(bank & 0x40) && offset < 0x2000) {
+        wram = offset;
+        end = 0x2000;
+    } else {
+        return;
+    }
+
+    uint8_t flag = write ? superpy::TRACE_WRITE : superpy::TRACE_READ;
+    bool hit = tracer.watch[wram] & flag;
+    // The high byte of a word at the region's last byte is not WRAM
+    // (e.g. $1FFF -> $2000, PPU I/O)
+    if (size == 2 && wram + 1 < end) hit = hit || (tracer.watch[wram + 1] & flag);
+    if (!hit) return;
+
+    size_t slot = (tracer.head + tracer.count) % tracer.ring.size();
+    if (tracer.count == tracer.ring.size()) {
+        // Full: overwrite the oldest
+        tracer.head = (tracer.head + 1) % tracer.ring.size();
+        tracer.lost++;
+    } else {
+        tracer.count++;
+    }
+
+    superpy::MemoryAccess& event = tracer.ring[slot];
+    event.address = wram;
+    event.pc = Registers.PBPC & 0xFFFFFF;
+    event.frame = tracer.frame;
+    event.value = static_cast<uint16_t>(value);
+    event.scanline = static_cast<uint16_t>(CPU.V_Counter);
+    event.flags = flag;
+    event.size = static_cast<uint8_t>(size);
+}
+
+// Timed wrappers that cpuexec.cpp and ppu.cpp call instead of the real
+// functions (see core_profile_hooks.h)
+using superpy::ProfileScope;
+
+void superpy_profiled_S9xUpdateScreen() {
+    ProfileScope scope(superpy::PROFILE_PPU);
+    S9xUpdateScreen();
+}
+
+void superpy_profiled_S9xEndScreenRefresh() {
+    ProfileScope scope(superpy::PROFILE_PPU);
+    S9xEndScreenRefresh();
+}
+
+void superpy_profiled_S9xAPUEndScanline() {
+    ProfileScope scope(superpy::PROFILE_APU);
+    S9xAPUEndScanline();
+}
+
+uint8 superpy_profiled_S9xAPUReadPort(int port) {
+    ProfileScope scope(superpy::PROFILE_APU);
+    return S9xAPUReadPort(port);
+}
+
+void superpy_profiled_S9xAPUWritePort(int port, uint8 byte) {
+    ProfileScope scope(superpy::PROFILE_APU);
+    S9xAPUWritePort(port, byte);
+}
+
+bool8 superpy_profiled_S9xDoDMA(uint8 channel) {
+    ProfileScope scope(superpy::PROFILE_DMA);
+    return S9xDoDMA(channel);
+}
+
+uint8 superpy_profiled_S9xDoHDMA(uint8 channels) {
+    ProfileScope scope(superpy::PROFILE_DMA);
+    return S9xDoHDMA(channels);
+}
+
+void superpy_profiled_S9xStartHDMA() {
+    ProfileScope scope(superpy::PROFILE_DMA);
+    S9xStartHDMA();
+}
+
+void superpy_profiled_S9xSA1MainLoop() {
+    ProfileScope scope(superpy::PROFILE_SA1);
+    S9xSA1MainLoop();
+}
+
+void superpy_profiled_S9xSuperFXExec() {
+    ProfileScope scope(superpy::PROFILE_SUPERFX);
+    S9xSuperFXExec();
+}
+
+extern "C" SUPERPY_CORE_EXPORT superpy::EmulatorCore* superpy_create_core() {
+    return new superpy::Snes9xCore();
+}
+
+
+// ============================================================================
+// Snes9x Platform Stubs (Required by the core)
+// ============================================================================
+
+void S9xMessage(int type, int number, const char* message) {
+    // Silent in headless mode
+}
+
+bool S9xPollButton(uint32 id, bool* pressed) {
+    *pressed = false;
+    return false;
+}
+
+bool S9xPollAxis(uint32 id, int16* value) {
+    *value = 0;
+    return false;
+}
+
+bool S9xPollPointer(uint32 id, int16* x, int16* y) {
+    *x = 0;
+    *y = 0;
+    return false;
+}
+
+void S9xToggleSoundChannel(int c) {}
+void S9xSetPalette() {}
+void S9xSyncSpeed() {}
+void S9xAutoSaveSRAM() {}
+
+// File/Directory functions
+std::string S9xGetDirectory(enum s9x_getdirtype type) {
+    return ".";
+}
+
+std::string S9xGetFilename(const char* extension, enum s9x_getdirtype type) {
+    return Memory.ROMFilename + extension;
+}
+
+std::string S9xGetFilenameInc(const char* extension, enum s9x_getdirtype type) {
+    return Memory.ROMFilename + extension;
+}
+
+std::string S9xGetFilenameInc(std::string extension, enum s9x_getdirtype type) {
+    return Memory.ROMFilename + extension;
+}
+
+std::string S9xChooseFilename(bool8 read_only) {
+    return "";
+}
+
+std::string S9xChooseMovieFilename(bool8 read_only) {
+    return "";
+}
+
+void S9xExit() {}
+
+// Graphics stubs
+bool8 S9xInitUpdate(void) {
+    return true;
+}
+
+bool8 S9xDeinitUpdate(int width, int height) {
+    return true;
+}
+
+bool8 S9xContinueUpdate(int width, int height) {
+    return true;
+}
+
+void S9xSetTitle(const char* title) {}
+void S9xProcessEvents(bool8 block) {}
+void S9xHandlePortCommand(s9xcommand_t cmd, int16 data1, int16 data2) {}
+
+bool8 S9xMapInput(const char* name, s9xcommand_t* cmd) {
+    return false;
+}
+
+// Snapshot file functions
+bool8 S9xOpenSnapshotFile(const char* filename, bool8 read_only, STREAM* file) {
+    *file = OPEN_STREAM(filename, read_only ? "rb" : "wb");
+    return *file != NULL;
+}
+
+void S9xCloseSnapshotFile(STREAM file) {
+    CLOSE_STREAM(file);
+}
+
+const char* S9xStringInput(const char* prompt) {
+    return "";
+}
+
+bool S9xDoScreenshot(int width, int height) {
+    return false;
+}
+
+const uint16* S9xGetCrosshair(int index) {
+    return nullptr;
+}
+
+// Sound device stub (required by S9xInitSound in apu.cpp)
+bool8 S9xOpenSoundDevice(void) {
+    // In headless mode, we don't need actual audio output
+    // Return true to indicate "success" so sound buffers are still updated
+    return true;
+}
@@ -0,0 +1,54 @@
+/**
+ * SuperPy State Pool
+ *
+ * Slots are laid out back to back, each starting on a cache line. The
+ * whole pool is zero-filled up front so the first save into a slot does
+ * not pay for page faults.
+ */
+
+#include "state_pool.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace superpy {
+
+static constexpr size_t SLOT_ALIGNMENT = 64;
+
+StatePool::StatePool(SuperPyEngine& engine, int slots)
+    : engine_(engine), state_size_(engine.state_size()) {
+    if (slots <= 0) {
+        throw std::invalid_argument("slots must be positive");
+    }
+    if (state_size_ == 0) {
+        throw std::invalid_argument("engine has no ROM loaded");
+    }
+
+    stride_ = (state_size_ + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+    data_.assign(static_cast<size_t>(slots) * stride_, 0);
+    occupied_.assign(slots, 0);
+}
+
+size_t StatePool::check(int slot) const {
+    if (slot < 0 || slot >= capacity()) {
+        throw std::out_of_range("slot " + std::to_string(slot) + " out of range for pool of " +
+                                std::to_string(capacity()));
+    }
+    return static_cast<size_t>(slot);
+}
+
+bool StatePool::save(int slot) {
+    uint8_t* dst = slot_data(slot);
+    if (engine_.state_size() != state_size_) return false;
+
+    bool ok = engine_.save_state_into(dst, state_size_);
+    occupied_[slot] = ok;
+    return ok;
+}
+
+bool StatePool::restore(int slot) {
+    if (!occupied(slot)) return false;
+    return engine_.load_state(slot_data(slot), state_size_);
+}
+
+} // namespace superpy
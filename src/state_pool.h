@@ -0,0 +1,54 @@
+/**
+ * SuperPy State Pool
+ *
+ * Preallocated snapshot slots for search workloads (MCTS, Go-Explore) that
+ * save and restore thousands of states per second.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "snes9x_adapter.h"
+
+namespace superpy {
+
+// K fixed-size slots in one contiguous allocation, addressed by integer
+// handle. Saving and restoring never allocate. The pool belongs to one
+// engine and must not outlive it.
+class StatePool {
+public:
+    // Throws std::invalid_argument if slots <= 0 or the engine has no ROM
+    StatePool(SuperPyEngine& engine, int slots);
+
+    int capacity() const { return static_cast<int>(occupied_.size()); }
+    size_t state_size() const { return state_size_; }
+    SuperPyEngine& engine() { return engine_; }
+
+    // Snapshot the engine into a slot, overwriting it. Throws
+    // std::out_of_range for invalid slots; false if the engine's state no
+    // longer fits (e.g. a different ROM was loaded).
+    bool save(int slot);
+
+    // Load a slot back into the engine; false if the slot is empty
+    bool restore(int slot);
+
+    bool occupied(int slot) const { return occupied_[check(slot)] != 0; }
+    void clear(int slot) { occupied_[check(slot)] = 0; }
+
+    // Raw snapshot bytes of a slot (state_size() bytes)
+    uint8_t* slot_data(int slot) { return data_.data() + check(slot) * stride_; }
+
+private:
+    size_t check(int slot) const;
+
+    SuperPyEngine& engine_;
+    size_t state_size_;
+    size_t stride_;                 // state_size_ rounded up to a cache line
+    std::vector<uint8_t> data_;
+    std::vector<uint8_t> occupied_;
+};
+
+} // namespace superpy
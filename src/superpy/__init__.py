@@ -20,8 +20,11 @@ from typing import TYPE_CHECKING
 if TYPE_CHECKING:
     from numpy.typing import NDArray
 
+    # Button dict, list of 12 bools, MultiBinary(12) array or raw joypad mask
+    Action = dict[str, bool] | list[bool] | NDArray | int
+
 try:
-    from ._core import Engine
+    from ._core import DeltaArchive, Engine, ForkServer, ObservationRing, StatePool, VectorEngine
 except ImportError as e:
     raise ImportError(
         "Failed to import SuperPy C++ core. "
@@ -44,6 +47,10 @@ class SuperPy:
         rom_path: Path to the SNES ROM file (.smc, .sfc, .zip)
         headless: Run without display (default True for speed)
         speed_limit: FPS limit, 0 = unlimited "warp mode" (default 0)
+        full_range_color: Expand colors to the full 0-255 range instead of
+            plain bit shifts (white is 248/252/248 otherwise)
+        video: False for RAM-only agents: no frame is ever rendered (the
+            PPU is still emulated) and screens/observations are black
     
     Example:
         >>> snes = SuperPy("your_game.smc", headless=True)
@@ -65,19 +72,21 @@ class SuperPy:
         self, 
         rom_path: str, 
         headless: bool = True,
-        speed_limit: int = 0
+        speed_limit: int = 0,
+        full_range_color: bool = False,
+        video: bool = True
     ) -> None:
-        self._engine = Engine()
+        self._engine = Engine(video)
+        self._engine.full_range_color = full_range_color
         self._headless = headless
         self._speed_limit = speed_limit
-        self._frame_count = 0
         
         if not self._engine.load_rom(rom_path):
             raise RuntimeError(f"Failed to load ROM: {rom_path}")
     
     def step(
         self, 
-        action: dict[str, bool] | list[bool] | None = None
+        action: Action | None = None
     ) -> NDArray[np.uint8]:
         """
         Advance emulation by one frame.
@@ -87,40 +96,63 @@ class SuperPy:
                 - dict mapping button names to pressed state
                   e.g., {"B": True, "Right": True}
                 - list of 12 booleans in BUTTONS order
+                - MultiBinary(12) numpy array in BUTTONS order
+                - int joypad mask (fastest, e.g. from action_mask())
                 - None for no input
         
         Returns:
             The current screen as a numpy array (H x W x 4 RGBA)
         """
-        # Convert list to dict if needed
-        if isinstance(action, list):
-            if len(action) != len(self.BUTTONS):
-                raise ValueError(f"Action list must have {len(self.BUTTONS)} elements")
-            action = {btn: pressed for btn, pressed in zip(self.BUTTONS, action)}
-        
-        self._engine.step(action or {})
-        self._frame_count += 1
+        self._engine.step(self._input(action))
         
         return self.screen
     
+    def step_skip(
+        self,
+        action: Action | None = None,
+        frames: int = 4,
+        pool: str = "max",
+        out: NDArray | None = None
+    ) -> NDArray:
+        """
+        Frame skip in a single native call.
+        
+        Holds the action for `frames` frames, rendering only the frames
+        that end up in the observation, and returns the observation
+        configured with set_observation().
+        
+        Args:
+            action: Controller input (same forms as step())
+            frames: Number of frames to run
+            pool: "max" = per-channel max of the last two frames (Atari-style),
+                  "last" = the last frame only
+            out: Optional preallocated array to write into
+        
+        Returns:
+            The observation array
+        """
+        return self._engine.step_skip(self._input(action), frames, pool, out)
+    
     def step_gym(
         self, 
-        action: dict[str, bool] | list[bool] | None = None
+        action: Action | None = None
     ) -> tuple[NDArray[np.uint8], float, bool, bool, dict]:
         """
         Gymnasium-compatible step function.
         
         Returns:
-            Tuple of (observation, reward, terminated, truncated, info)
-            Note: reward is always 0.0 - use RAM reading for custom rewards
+            Tuple of (observation, reward, terminated, truncated, info).
+            Reward and flags come from the reward program (see set_reward());
+            without one the reward is 0.0 and the episode never ends.
         """
         obs = self.step(action)
-        return obs, 0.0, self.done, False, {"frame": self._frame_count}
+        reward = self._engine.take_reward()
+        return obs, reward, self._engine.terminated, self._engine.truncated, {"frame": self._engine.frame_count}
     def tick(
         self, 
         count: int = 1, 
         render: bool = True,
-        action: dict[str, bool] | list[bool] | None = None
+        action: Action | None = None
     ) -> int:
         """
         Run multiple frames at maximum speed (warp mode).
@@ -134,7 +166,8 @@ class SuperPy:
             action: Controller input to hold during all frames
         
         Returns:
-            Number of frames executed
+            Number of frames executed; fewer than count if a watch fired
+            (see set_watches())
         
         Example:
             >>> # Simulate 1 hour of gameplay in ~36 seconds
@@ -143,15 +176,58 @@ class SuperPy:
             >>> # Fast-forward with held buttons
             >>> snes.tick(600, render=False, action={"Right": True, "B": True})
         """
-        # Convert list to dict if needed
+        return self._engine.tick(count, render, self._input(action))
+    
+    def _input(self, action: Action | None) -> dict | NDArray | int:
+        # Lists go through the native MultiBinary path; everything else is
+        # converted natively without building a dict
+        if action is None:
+            return 0
         if isinstance(action, list):
             if len(action) != len(self.BUTTONS):
                 raise ValueError(f"Action list must have {len(self.BUTTONS)} elements")
-            action = {btn: pressed for btn, pressed in zip(self.BUTTONS, action)}
+            return np.asarray(action, dtype=np.uint8)
+        return action
+    
+    def set_action_table(self, actions: list[Action]) -> None:
+        """
+        Register a discrete action set, e.g. the 14 button combos of a game.
         
-        self._engine.tick(count, render, action or {})
-        self._frame_count += count
-        return count
+        Args:
+            actions: One entry per action index, in any form step() accepts
+        
+        Example:
+            >>> snes.set_action_table([{}, {"Right": True}, {"Right": True, "B": True}])
+            >>> snes.step_action(2)
+        """
+        masks = []
+        for action in actions:
+            action = self._input(action)
+            masks.append(action if isinstance(action, int) else Engine.buttons_to_mask(action))
+        self._engine.set_action_table(masks)
+    
+    def action_mask(self, index: int) -> int:
+        """Joypad mask of a discrete action registered with set_action_table()."""
+        return self._engine.action_mask(index)
+    
+    def step_action(self, index: int) -> NDArray[np.uint8]:
+        """step() with a discrete action index, resolved in the same native call."""
+        self._engine.step_action(index)
+        return self.screen
+    
+    def tick_action(self, index: int, count: int = 1, render: bool = True) -> int:
+        """tick() with a discrete action index, resolved in the same native call."""
+        return self._engine.tick_action(index, count, render)
+    
+    def step_skip_action(
+        self,
+        index: int,
+        frames: int = 4,
+        pool: str = "max",
+        out: NDArray | None = None
+    ) -> NDArray:
+        """step_skip() with a discrete action index, resolved in the same native call."""
+        return self._engine.step_skip_action(index, frames, pool, out)
     
     @property
     def screen(self) -> NDArray[np.uint8]:
@@ -167,6 +243,202 @@ class SuperPy:
         """
         return self._engine.screen
     
+    def set_observation(self, **spec) -> None:
+        """
+        Configure the native observation pipeline used by observe().
+        
+        Args:
+            crop: (x, y, width, height) in 256x224 screen coordinates
+            size: (height, width) of the output
+            interpolation: "nearest" or "area"
+            color: "rgb", "gray", "rgb565" (uint16) or "palette" (RGB332 index)
+            layout: "hwc" or "chw"
+            full_range: Expand colors to the full 0-255 range
+        
+        Example:
+            >>> snes.set_observation(size=(84, 84), color="gray", interpolation="area")
+            >>> obs = snes.observe()  # (84, 84, 1) uint8
+        """
+        self._engine.set_observation(**spec)
+    
+    def observe(self, out: NDArray | None = None) -> NDArray:
+        """
+        Build the configured observation straight from the native frame.
+        
+        Args:
+            out: Optional preallocated array to write into (no allocation)
+        
+        Returns:
+            The observation array (``out`` itself if given)
+        """
+        return self._engine.observe(out)
+    
+    def set_features(self, features: list[dict] | None, dtype: str = "float32") -> None:
+        """
+        Compile a list of RAM features once, read natively by features().
+        
+        Args:
+            features: One dict per feature, in output order:
+                address: WRAM offset (int, or "0x..."/"$..." hex or decimal string)
+                type: "u8" (default), "s8", "u16", "s16" or "u24"
+                endian: "little" (default) or "big"
+                bcd: Packed BCD (e.g. scores shown digit by digit)
+                mask, shift: Bitfield, value = (value & mask) >> shift
+                scale: Multiplier (float32 only)
+                Entries of the RAM map JSON format (name, description) work
+                as they are. None clears the features.
+            dtype: "float32" or "int32"
+        
+        Example:
+            >>> snes.set_features([
+            ...     {"address": 0x94, "type": "u16"},     # player_x
+            ...     {"address": 0x96, "type": "u16"},     # player_y
+            ...     {"address": 0xDBE},                   # lives
+            ... ])
+            >>> snes.step_skip(action)
+            >>> x, y, lives = snes.features()
+        """
+        self._engine.set_features(features, dtype)
+    
+    def features(self, out: NDArray | None = None) -> NDArray:
+        """
+        Gather the RAM features of the current frame (see set_features()).
+        
+        Args:
+            out: Optional preallocated array to write into (no allocation)
+        
+        Returns:
+            1-D float32/int32 array, one value per feature
+        """
+        return self._engine.features(out)
+    
+    def set_reward(
+        self,
+        reward: str | None = None,
+        terminated: str | None = None,
+        truncated: str | None = None,
+    ) -> None:
+        """
+        Compile reward and termination expressions over RAM, evaluated
+        natively after every emulated frame (skipped ones included).
+        
+        Expressions read RAM as u8/s8/u16/s16/u24[addr] (u16be, s16be,
+        u24be for big-endian, bcd8/bcd16/bcd24 for packed BCD), compare
+        against the previous frame with prev(e), delta(e), increased(e),
+        decreased(e) and changed(e), and combine with + - * / %,
+        comparisons, && || !, & | << >>, c ? a : b, min, max, sum, clamp
+        and abs. `frame` counts frames since the episode start, which is
+        every reset(), load_state() and rewind().
+        
+        Args:
+            reward: Reward added up over the frames of each step
+            terminated: Ends the episode once true on any frame
+            truncated: Truncates the episode once true on any frame
+            All None clears the program.
+        
+        Raises:
+            ValueError: On a malformed expression
+        
+        Example:
+            >>> snes.set_reward(
+            ...     reward="delta(bcd24[0x0F34]) - 100 * decreased(u8[0x0DBE])",
+            ...     terminated="u8[0x0DBE] == 0",
+            ...     truncated="frame >= 18000",
+            ... )
+            >>> obs, reward, terminated, truncated, info = snes.step_gym(action)
+        """
+        self._engine.set_reward(reward, terminated, truncated)
+    
+    def take_reward(self) -> float:
+        """Reward accumulated since the last call or the episode start."""
+        return self._engine.take_reward()
+    
+    def set_watches(self, watches: list[dict] | None) -> None:
+        """
+        Watch RAM after every frame; tick() stops on the frame a watch fires.
+        
+        Args:
+            watches: One dict per watch:
+                address: WRAM offset (int, or "0x..."/"$..." hex or decimal string)
+                kind: "changed" (default): any of `length` bytes changed
+                      "equals": the value becomes `value`
+                      "rises": the value crosses `value` upwards
+                      "falls": the value crosses `value` downwards
+                length: Bytes compared by "changed" (default 1)
+                value: Value or threshold for the other kinds
+                type, endian, bcd, mask, shift: How the value is read, as
+                in set_features()
+                None clears the watches.
+        
+        Example:
+            >>> snes.set_watches([
+            ...     {"address": 0xDBE, "kind": "changed"},            # lives
+            ...     {"address": 0x71, "kind": "equals", "value": 9},  # death animation
+            ... ])
+            >>> frames = snes.tick(600, render=False)
+            >>> if snes.watch_hit:
+            ...     watch, frame = snes.watch_hit
+        """
+        self._engine.set_watches(watches)
+    
+    def trace_memory(
+        self,
+        address: int,
+        length: int = 1,
+        reads: bool = False,
+        writes: bool = True,
+        capacity: int | None = None,
+    ) -> None:
+        """
+        Record which instructions read or write some WRAM bytes.
+        
+        Every matching 65816 access is stored natively in a preallocated
+        ring (see trace_events()); calls add to the bytes already traced.
+        Tracing costs nothing measurable while off.
+        
+        Args:
+            address: First WRAM offset
+            length: Number of bytes
+            reads: Trace reads
+            writes: Trace writes
+            capacity: Events kept before the oldest are overwritten
+                (default 65536; changing it drops pending events)
+        
+        Example:
+            >>> snes.trace_memory(0x0DBE)          # who writes the lives counter?
+            >>> snes.tick(600, render=False)
+            >>> events = snes.trace_events()
+            >>> hex(events["pc"][0]), events["value"][0], events["frame"][0]
+        """
+        if capacity is not None:
+            self._engine.trace_capacity = capacity
+        self._engine.trace_memory(address, length, reads, writes)
+    
+    def trace_events(self) -> dict[str, NDArray]:
+        """
+        Take the traced accesses since the last call, oldest first.
+        
+        Returns:
+            Dict of equal-length arrays: address (WRAM offset), value, pc
+            (bank:PC just past the instruction's operand bytes), frame,
+            scanline, size (1 or 2 bytes) and write (1 = write, 0 = read)
+        """
+        return self._engine.trace_events()
+    
+    def clear_trace(self) -> None:
+        """Stop tracing memory accesses."""
+        self._engine.clear_trace()
+    
+    @property
+    def trace_lost(self) -> int:
+        """Traced events overwritten before trace_events() took them."""
+        return self._engine.trace_lost
+    
+    @property
+    def watch_hit(self) -> tuple[int, int] | None:
+        """(watch index, frame_count) of the first watch fired during the last step/tick call, or None."""
+        return self._engine.watch_hit
+    
     @property
     def memory(self) -> NDArray[np.uint8]:
         """
@@ -184,27 +456,117 @@ class SuperPy:
         """
         return self._engine.memory
     
+    def mark_ram(self) -> None:
+        """Take the reference copy of RAM that ram_diff() compares against."""
+        self._engine.mark_ram()
+    
+    def ram_diff(
+        self,
+        advance: bool = False,
+        max_changes: int | None = None,
+    ) -> tuple[NDArray[np.uint32], NDArray[np.uint8], NDArray[np.uint8]]:
+        """
+        Find the RAM bytes that changed since mark_ram(), natively with
+        SIMD compares (no 128KB copies in Python).
+        
+        Args:
+            advance: Make the current RAM the new reference, so every call
+                reports the changes since the previous one (e.g. per step)
+            max_changes: Report at most this many bytes (lowest addresses)
+        
+        Returns:
+            (indices, old, new): changed WRAM offsets in address order and
+            their reference and current values. Without a reference yet
+            (first call, new ROM) this marks and returns empty arrays.
+        
+        Example:
+            >>> snes.mark_ram()
+            >>> snes.step({"Right": True})
+            >>> indices, old, new = snes.ram_diff()
+            >>> candidates = indices[new == old + 1]   # counters that went up
+        """
+        return self._engine.ram_diff(advance, max_changes)
+    
     @property
     def done(self) -> bool:
-        """Whether the emulation has ended."""
+        """Whether the reward program ended the episode (terminated or truncated)."""
         return self._engine.done
     
+    @property
+    def terminated(self) -> bool:
+        """Whether the reward program's terminated expression held this episode."""
+        return self._engine.terminated
+    
+    @property
+    def truncated(self) -> bool:
+        """Whether the reward program's truncated expression held this episode."""
+        return self._engine.truncated
+    
     @property
     def frame_count(self) -> int:
-        """Number of frames executed since ROM load."""
-        return self._frame_count
+        """Frames run in the current episode (reset by reset(), load_state() and ROM load)."""
+        return self._engine.frame_count
+    
+    @property
+    def profiling(self) -> bool:
+        """Whether every frame's time is split by subsystem (see profile_stats())."""
+        return self._engine.profiling
+    
+    @profiling.setter
+    def profiling(self, enabled: bool) -> None:
+        self._engine.profiling = enabled
     
-    def reset(self) -> NDArray[np.uint8]:
+    def profile_stats(self) -> dict:
+        """
+        Frame time per subsystem over the last 4096 profiled frames.
+    
+        Returns:
+            {"cpu", "ppu", "apu", "dma", "sa1", "superfx", "screen", "total"}
+            each mapped to {"mean_us", "p50_us", "p99_us"}, plus "frames":
+            the number of frames covered
+        """
+        return self._engine.profile_stats()
+    
+    def reset(self, index: int | None = None) -> NDArray[np.uint8]:
         """
         Reset the game to initial state.
         
+        With start states recorded by add_reset_state(), the game is
+        restored to one of them (in turn, or `index`) instead of being
+        power-cycled.
+        
+        Args:
+            index: Start state to restore (requires add_reset_state())
+        
         Returns:
             The initial screen observation
         """
-        self._engine.reset()
-        self._frame_count = 0
+        if index is None:
+            self._engine.reset()
+        else:
+            self._engine.reset_to(index)
         return self.screen
     
+    def add_reset_state(self) -> int:
+        """
+        Record the current state as a start state for reset().
+        
+        Restoring a snapshot is far cheaper than power-cycling and replaying
+        the intro, and several start states give episode diversity.
+        
+        Example:
+            >>> snes.tick(300, render=False, action={"Start": True})
+            >>> snes.add_reset_state()
+            >>> snes.reset()  # back to the post-intro state
+        
+        Returns:
+            Index of the new start state
+        """
+        index = self._engine.add_reset_state()
+        if index < 0:
+            raise RuntimeError("Failed to save the start state")
+        return index
+    
     def save_state(self) -> bytes:
         """
         Save the complete emulator state.
@@ -217,16 +579,134 @@ class SuperPy:
             >>> # ... do something risky ...
             >>> snes.load_state(state)  # Rewind time!
         """
-        return bytes(self._engine.save_state())
+        return self._engine.save_state()
+    
+    def enable_rewind(self, depth: int = 600, stride: int = 1, buffer_size: int = 0) -> None:
+        """
+        Record a native rewind history while the game runs.
+        
+        Snapshots are taken every `stride` frames into a delta-compressed
+        ring inside the emulator core; the newest `depth` are kept.
+        
+        Args:
+            depth: Number of snapshots to keep
+            stride: Frames between snapshots
+            buffer_size: Ring size in bytes (0 = estimate from depth)
+        
+        Example:
+            >>> snes.enable_rewind(depth=300, stride=2)   # ~10s of history
+            >>> # ... player dies ...
+            >>> snes.rewind(120)                          # back 2 seconds
+        """
+        if not self._engine.enable_rewind(depth, stride, buffer_size):
+            raise RuntimeError("Failed to allocate the rewind buffer")
+    
+    def rewind(self, frames: int) -> int:
+        """
+        Go back at least `frames` frames, as far as the history reaches.
+        
+        Returns:
+            Number of frames actually rewound (0 if there is no history)
+        """
+        return self._engine.rewind(frames)
+    
+    def save_state_into(self, buffer: bytearray | memoryview | NDArray[np.uint8]) -> int:
+        """
+        Save the state into a preallocated buffer, without allocating.
+        
+        Args:
+            buffer: Writable contiguous buffer of at least state_size() bytes
+        
+        Returns:
+            Number of bytes written
+        
+        Example:
+            >>> states = np.empty((1000, snes.state_size()), dtype=np.uint8)
+            >>> snes.save_state_into(states[0])
+        """
+        written = self._engine.save_state_into(buffer)
+        if not written:
+            raise RuntimeError("Failed to save state")
+        return written
+    
+    def state_pool(self, slots: int) -> StatePool:
+        """
+        Preallocate `slots` snapshot slots for this emulator.
+        
+        Saving and restoring by slot number never allocates or touches
+        Python bytes, which is what MCTS / Go-Explore style search needs.
+        
+        Example:
+            >>> pool = snes.state_pool(1024)
+            >>> pool.save(0)
+            >>> snes.tick(60, render=False)
+            >>> pool.restore(0)
+        """
+        return StatePool(self._engine, slots)
+    
+    def delta_archive(self, keyframe_interval: int = 32) -> DeltaArchive:
+        """
+        Create an archive that stores snapshots as deltas against a parent.
+        
+        Nearby states differ in a few KB, so archiving millions of cells
+        (Go-Explore style) costs a fraction of full snapshots. Every
+        keyframe_interval-th link of a chain is stored in full, bounding
+        restore cost.
+        
+        Example:
+            >>> archive = snes.delta_archive()
+            >>> root = archive.save()
+            >>> snes.tick(30, render=False)
+            >>> child = archive.save(parent=root)
+            >>> archive.restore(root)
+        """
+        return DeltaArchive(self._engine, keyframe_interval)
+    
+    def fork(self, num_workers: int) -> ForkServer:
+        """
+        Fork `num_workers` worker processes from this emulator as it is now.
+        
+        Each worker starts from a copy-on-write copy of the loaded ROM and
+        current state, so spawning many of them costs milliseconds instead
+        of a Python start-up, ROM load and intro per worker. Workers are
+        stepped together and write into shared buffers (POSIX only).
+        
+        Example:
+            >>> snes.tick(600, render=False)       # play the intro once
+            >>> with snes.fork(128) as workers:
+            ...     obs, rewards, dones = workers.step(actions, frames=4)
+        """
+        return ForkServer(self._engine, num_workers)
+    
+    def push(self, ring: ObservationRing, env: int, reward: float = 0.0, done: bool | None = None) -> bool:
+        """
+        Publish this emulator's current observation into a shared ring.
+        
+        Worker processes call this after every step instead of sending
+        frames back through a pipe; the learner reads the whole batch with
+        ring.wait(). `done` defaults to the emulator's own flag.
+        
+        Example:
+            >>> ring = ObservationRing.attach("superpy_ring")
+            >>> snes.set_observation(size=(84, 84), color="gray")
+            >>> snes.step_skip(action)
+            >>> snes.push(ring, env=worker_index, reward=reward)
+        """
+        return ring.push(env, self._engine, reward, self.done if done is None else done)
+    
+    def state_size(self) -> int:
+        """Size in bytes of a saved state for the loaded ROM."""
+        return self._engine.state_size()
     
-    def load_state(self, state: bytes) -> None:
+    def load_state(self, state: bytes | bytearray | memoryview | NDArray[np.uint8]) -> None:
         """
         Restore a previously saved state.
         
         Args:
-            state: State data from save_state()
+            state: State data from save_state() or save_state_into(); any
+                contiguous buffer is read in place
         """
-        if not self._engine.load_state(list(state)):
+        if not self._engine.load_state(state):
             raise RuntimeError("Failed to load state")
     
     def save_screenshot(self, path: str) -> None:
@@ -250,7 +730,7 @@ class SuperPy:
         img.save(path)
     
     def __repr__(self) -> str:
-        return f"SuperPy(frame={self._frame_count}, done={self.done})"
+        return f"SuperPy(frame={self.frame_count}, done={self.done})"
     
     # Jupyter notebook integration
     def _repr_png_(self) -> bytes:
@@ -274,7 +754,7 @@ from .env import SuperPyEnv
 # Export async controller
 from .async_controller import AsyncController
 
-__all__ = ["SuperPy", "SuperPyEnv", "AsyncController", "__version__"]
+__all__ = ["SuperPy", "SuperPyEnv", "AsyncController", "VectorEngine", "StatePool", "DeltaArchive", "ForkServer", "ObservationRing", "__version__"]
 
 # Register with gymnasium
 try:
@@ -20,6 +20,7 @@ except ImportError:
 
 if HAS_GYMNASIUM:
     from . import SuperPy
+    from ._core import observation_shape
 
     class SuperPyEnv(gym.Env):
         """
@@ -38,10 +39,37 @@ if HAS_GYMNASIUM:
             rom_path: Path to the SNES ROM file
             render_mode: "rgb_array" for visual obs, None for headless
             frame_skip: Frames to skip per step (default 4)
+            frame_pool: "last" or "max" (max over the last two frames);
+                applies when a native observation spec is set
             reward_address: RAM address to read reward delta from
+                (shorthand for reward="delta(u8[address])")
+            reward: Reward expression over RAM, evaluated natively after
+                every frame (see SuperPy.set_reward)
+            terminated: Termination expression, e.g. "u8[0x0DBE] == 0"
+            truncated: Truncation expression, e.g. "frame >= 18000"
             max_episode_steps: Maximum steps before truncation
+            observation: Native observation spec (see SuperPy.set_observation),
+                e.g. {"size": (84, 84), "color": "gray", "interpolation": "area"}.
+                None keeps the raw 224x256x4 RGBA screen.
+            actions: Discrete action set (button dicts or lists, see
+                SuperPy.set_action_table). The action space becomes
+                Discrete(len(actions)) instead of MultiBinary(12).
+            warmup: Input script run once to get past the intro, as a list
+                of (action, frames) pairs. Default: Start for 300 frames,
+                then 60 idle frames.
+            fast_reset: Snapshot the state after the warmup once and restore
+                it on every reset, instead of reloading the ROM and
+                replaying the warmup each episode
+            reset_states: Number of start states to capture for fast reset,
+                each a random 1-30 idle frames after the previous one; every
+                reset picks one at random
+            features: RAM features (see SuperPy.set_features) gathered
+                natively after every step into info["features"] (float32)
         """
         
+        # Start for 300 frames, then 60 idle frames
+        DEFAULT_WARMUP = (({"Start": True}, 300), ({}, 60))
+        
         metadata = {"render_modes": ["rgb_array", "human"], "render_fps": 60}
         
         def __init__(
@@ -49,47 +77,118 @@ if HAS_GYMNASIUM:
             rom_path: str,
             render_mode: str | None = None,
             frame_skip: int = 4,
+            frame_pool: str = "last",
             reward_address: int | None = None,
             max_episode_steps: int = 10000,
+            observation: dict | None = None,
+            actions: list | None = None,
+            warmup: list | None = None,
+            fast_reset: bool = True,
+            reset_states: int = 1,
+            features: list | None = None,
+            reward: str | None = None,
+            terminated: str | None = None,
+            truncated: str | None = None,
         ):
             super().__init__()
             
             self.rom_path = rom_path
             self.render_mode = render_mode
             self.frame_skip = frame_skip
+            self.frame_pool = frame_pool
             self.reward_address = reward_address
             self.max_episode_steps = max_episode_steps
+            self.observation = observation
+            self.actions = actions
+            self.warmup = self.DEFAULT_WARMUP if warmup is None else warmup
+            self.fast_reset = fast_reset
+            self.reset_states = reset_states
+            self.features = features
+            if reward is None and reward_address is not None:
+                reward = f"delta(u8[{reward_address:#x}])"
+            self.reward = reward
+            self.terminated = terminated
+            self.truncated = truncated
             
             self._snes: SuperPy | None = None
             self._step_count = 0
-            self._prev_reward_value = 0
             
-            # Action space: 12 buttons (can be extended to discrete)
-            self.action_space = spaces.MultiBinary(12)
+            # Action space: 12 buttons, or indices into a discrete action set
+            if actions is None:
+                self.action_space = spaces.MultiBinary(12)
+            else:
+                self.action_space = spaces.Discrete(len(actions))
+            
+            if observation is None:
+                # Observation space: 224x256x4 RGBA screen
+                shape, dtype = (224, 256, 4), np.uint8
+            else:
+                # Native pipeline (full_range does not affect the shape)
+                spec = {k: v for k, v in observation.items() if k != "full_range"}
+                shape = observation_shape(**spec)
+                dtype = np.uint16 if observation.get("color") == "rgb565" else np.uint8
             
-            # Observation space: 224x256x4 RGBA screen
             self.observation_space = spaces.Box(
-                low=0, high=255,
-                shape=(224, 256, 4),
-                dtype=np.uint8
+                low=0, high=np.iinfo(dtype).max,
+                shape=shape,
+                dtype=dtype
             )
         
+        def _observe(self) -> np.ndarray:
+            if self.observation is None:
+                return self._snes.screen.copy()
+            return self._snes.observe()
+        
         def reset(
             self, *, seed: int | None = None, options: dict | None = None
         ) -> tuple[np.ndarray, dict]:
             super().reset(seed=seed)
             
-            self._snes = SuperPy(self.rom_path, headless=True)
             self._step_count = 0
-            self._prev_reward_value = 0
             
-            # Skip intro screens (common for SNES games)
-            for _ in range(300):
-                self._snes.step({"Start": True})
-            for _ in range(60):
+            if self._snes is None or not self.fast_reset:
+                self._start()
+            if self.fast_reset:
+                # Restore a captured start state in place (plus one rendered frame)
+                self._snes.reset(int(self.np_random.integers(self.reset_states)))
+            
+            return self._observe(), self._info({"frame": self._snes.frame_count})
+        
+        def _info(self, info: dict) -> dict:
+            if self.features is not None:
+                info["features"] = self._snes.features()
+            return info
+        
+        def _start(self) -> None:
+            # Boot the ROM and play the warmup script
+            self._snes = SuperPy(self.rom_path, headless=True)
+            if self.observation is not None:
+                self._snes.set_observation(**self.observation)
+            if self.actions is not None:
+                self._snes.set_action_table(self.actions)
+            if self.features is not None:
+                self._snes.set_features(self.features)
+            
+            # Nothing is observed until the episode starts
+            for action, frames in self.warmup:
+                self._snes.tick(frames, render=False, action=action)
+            
+            if not self.fast_reset:
+                # Render the first observed frame; the episode starts here
                 self._snes.step({})
+                self._set_reward()
+                return
             
-            return self._snes.screen.copy(), {"frame": self._snes.frame_count}
+            # Restoring a start state starts the episode
+            self._set_reward()
+            for i in range(self.reset_states):
+                if i > 0:
+                    self._snes.tick(int(self.np_random.integers(1, 31)), render=False)
+                self._snes.add_reset_state()
+        
+        def _set_reward(self) -> None:
+            if self.reward is not None or self.terminated is not None or self.truncated is not None:
+                self._snes.set_reward(self.reward, self.terminated, self.truncated)
         
         def step(
             self, action: np.ndarray
@@ -97,31 +196,37 @@ if HAS_GYMNASIUM:
             if self._snes is None:
                 raise RuntimeError("Environment not reset. Call reset() first.")
             
-            # Convert action array to button dict
-            buttons = dict(zip(SuperPy.BUTTONS, action.astype(bool)))
-            
-            # Frame skip with tick for speed
-            for _ in range(self.frame_skip):
-                self._snes.step(buttons)
+            # Frame skip natively, rendering only the observed frames. Action
+            # indices are resolved in the same native call, no per-step dict.
+            if self.actions is None:
+                buttons = np.asarray(action, dtype=np.uint8)
+                if self.observation is None:
+                    self._snes.tick(self.frame_skip - 1, render=False, action=buttons)
+                    self._snes.step(buttons)
+                    obs = self._snes.screen.copy()
+                else:
+                    obs = self._snes.step_skip(buttons, self.frame_skip, pool=self.frame_pool)
+            else:
+                index = int(action)
+                if self.observation is None:
+                    self._snes.tick_action(index, self.frame_skip - 1, render=False)
+                    obs = self._snes.step_action(index).copy()
+                else:
+                    obs = self._snes.step_skip_action(index, self.frame_skip, pool=self.frame_pool)
             
             self._step_count += 1
             
-            # Compute reward from RAM (if configured)
-            reward = 0.0
-            if self.reward_address is not None:
-                curr = int(self._snes.memory[self.reward_address])
-                reward = float(curr - self._prev_reward_value)
-                self._prev_reward_value = curr
-            
-            terminated = self._snes.done
-            truncated = self._step_count >= self.max_episode_steps
+            # Summed natively over every frame of the step (0 without a program)
+            reward = self._snes.take_reward()
+            terminated = self._snes.terminated
+            truncated = self._snes.truncated or self._step_count >= self.max_episode_steps
             
             return (
-                self._snes.screen.copy(),
+                obs,
                 reward,
                 terminated,
                 truncated,
-                {"frame": self._snes.frame_count, "step": self._step_count}
+                self._info({"frame": self._snes.frame_count, "step": self._step_count})
             )
         
         def render(self) -> np.ndarray | None:
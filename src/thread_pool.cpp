@@ -0,0 +1,205 @@
+/**
+ * SuperPy Thread Pool
+ */
+
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace superpy {
+
+static inline uint64_t pack(uint32_t begin, uint32_t end) {
+    return static_cast<uint64_t>(end) << 32 | begin;
+}
+
+static inline uint32_t queue_begin(uint64_t bounds) { return static_cast<uint32_t>(bounds); }
+static inline uint32_t queue_end(uint64_t bounds) { return static_cast<uint32_t>(bounds >> 32); }
+
+ThreadPool::ThreadPool(int num_threads)
+    : task_(nullptr), steals_(0), active_(0), generation_(0), stop_(false) {
+    if (num_threads <= 0) {
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (num_threads <= 0) num_threads = 1;
+    }
+    queues_.reset(new Queue[num_threads]);
+
+    // The calling thread always takes part in a batch, as thread 0
+    for (int i = 1; i < num_threads; i++) {
+        workers_.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(int count, const std::function<void(int)>& fn, const float* costs) {
+    if (count <= 0) return;
+
+    // Nothing to share: skip the handshake entirely
+    if (workers_.empty() || count == 1) {
+        for (int i = 0; i < count; i++) fn(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        plan(count, costs);
+        task_ = &fn;
+        active_ = static_cast<int>(workers_.size());
+        generation_++;
+    }
+    work_cv_.notify_all();
+
+    run_batch(0);
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return active_ == 0; });
+        task_ = nullptr;
+        error = error_;
+        error_ = nullptr;
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+void ThreadPool::plan(int count, const float* costs) {
+    int threads = size();
+    order_.resize(count);
+
+    // Nothing measured yet (all zero): the equal split beats dealing blind
+    if (costs && std::all_of(costs, costs + count, [](float cost) { return cost <= 0.0f; })) {
+        costs = nullptr;
+    }
+
+    if (!costs) {
+        for (int i = 0; i < count; i++) order_[i] = i;
+        for (int t = 0; t < threads; t++) {
+            uint32_t begin = static_cast<uint32_t>(static_cast<int64_t>(count) * t / threads);
+            uint32_t end = static_cast<uint32_t>(static_cast<int64_t>(count) * (t + 1) / threads);
+            queues_[t].bounds.store(pack(begin, end), std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    // Longest processing time first: each item to the least loaded queue
+    by_cost_.resize(count);
+    for (int i = 0; i < count; i++) by_cost_[i] = {costs[i], i};
+    std::stable_sort(by_cost_.begin(), by_cost_.end(),
+                     [](const std::pair<float, int>& a, const std::pair<float, int>& b) { return a.first > b.first; });
+
+    loads_.assign(threads, 0.0);
+    queue_of_.resize(count);
+    fill_.assign(threads, 0);
+    for (const auto& item : by_cost_) {
+        // Ties (equal costs) go to the queue with fewer items
+        int target = 0;
+        for (int t = 1; t < threads; t++) {
+            if (loads_[t] < loads_[target] || (loads_[t] == loads_[target] && fill_[t] < fill_[target])) {
+                target = t;
+            }
+        }
+        loads_[target] += std::max(item.first, 0.0f);
+        queue_of_[item.second] = target;
+        fill_[target]++;
+    }
+
+    // Lay the queues out back to back, each still in descending cost order:
+    // owners start on their most expensive item, thieves take the cheapest
+    uint32_t begin = 0;
+    for (int t = 0; t < threads; t++) {
+        uint32_t end = begin + fill_[t];
+        queues_[t].bounds.store(pack(begin, end), std::memory_order_relaxed);
+        fill_[t] = begin;  // now the fill position
+        begin = end;
+    }
+    for (const auto& item : by_cost_) {
+        order_[fill_[queue_of_[item.second]]++] = item.second;
+    }
+}
+
+bool ThreadPool::pop(int thread, int& item) {
+    std::atomic<uint64_t>& bounds = queues_[thread].bounds;
+    uint64_t current = bounds.load(std::memory_order_acquire);
+    for (;;) {
+        uint32_t begin = queue_begin(current);
+        uint32_t end = queue_end(current);
+        if (begin >= end) return false;
+        if (bounds.compare_exchange_weak(current, pack(begin + 1, end), std::memory_order_acq_rel)) {
+            item = order_[begin];
+            return true;
+        }
+    }
+}
+
+bool ThreadPool::steal(int thread, int& item) {
+    for (;;) {
+        // Victim: the queue with the most items left
+        int victim = -1;
+        uint32_t most = 0;
+        uint64_t victim_bounds = 0;
+        for (int t = 0; t < size(); t++) {
+            if (t == thread) continue;
+            uint64_t bounds = queues_[t].bounds.load(std::memory_order_acquire);
+            uint32_t left = queue_end(bounds) > queue_begin(bounds) ? queue_end(bounds) - queue_begin(bounds) : 0;
+            if (left > most) {
+                most = left;
+                victim = t;
+                victim_bounds = bounds;
+            }
+        }
+        if (victim < 0) return false;
+
+        uint32_t end = queue_end(victim_bounds) - 1;
+        if (queues_[victim].bounds.compare_exchange_strong(victim_bounds, pack(queue_begin(victim_bounds), end),
+                                                           std::memory_order_acq_rel)) {
+            item = order_[end];
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+void ThreadPool::run_batch(int thread) {
+    int item;
+    while (pop(thread, item) || steal(thread, item)) {
+        // Keep draining after a failure: every thread must be done with
+        // task_ before parallel_for() returns or rethrows
+        try {
+            (*task_)(item);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_) error_ = std::current_exception();
+        }
+    }
+}
+
+void ThreadPool::worker_loop(int thread) {
+    uint64_t seen = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+        }
+
+        run_batch(thread);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--active_ == 0) done_cv_.notify_one();
+        }
+    }
+}
+
+} // namespace superpy
@@ -0,0 +1,84 @@
+/**
+ * SuperPy Thread Pool
+ *
+ * Minimal fixed-size work-stealing pool used to step many engines at once.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace superpy {
+
+class ThreadPool {
+public:
+    // num_threads: total threads working on a batch, including the caller.
+    // 0 = one per hardware thread.
+    explicit ThreadPool(int num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+    // Run fn(i) for every i in [0, count) and wait for all of them. Each
+    // thread starts on its own queue of items and, once that is empty,
+    // steals from the back of the fullest other queue, so slow items do not
+    // leave the other threads idle. Not reentrant: one batch at a time.
+    // If fn throws, the remaining items still run and the first exception
+    // is rethrown once the batch is done.
+    //
+    // costs (optional, count entries): expected cost of each item. Queues
+    // are then dealt longest-first to the least loaded thread, so stealing
+    // only has to absorb the estimation error; without costs (or with all
+    // of them zero) every thread gets an equal contiguous share.
+    void parallel_for(int count, const std::function<void(int)>& fn, const float* costs = nullptr);
+
+    // Items run by a thread other than the one they were queued on, since
+    // construction
+    uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    // A thread's queue: order_[begin, end), packed into one word so the
+    // owner (popping the front) and thieves (popping the back) can race
+    // with a single compare-and-swap
+    struct alignas(64) Queue {
+        std::atomic<uint64_t> bounds{0};
+    };
+
+    void plan(int count, const float* costs);
+    void worker_loop(int thread);
+    void run_batch(int thread);
+    bool pop(int thread, int& item);
+    bool steal(int thread, int& item);
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+
+    const std::function<void(int)>* task_;
+    std::exception_ptr error_;            // first exception of the batch
+    std::vector<int> order_;              // items grouped by queue
+    std::unique_ptr<Queue[]> queues_;     // one per thread, 0 = caller
+    std::vector<std::pair<float, int>> by_cost_;  // plan() scratch
+    std::vector<double> loads_;                   // plan() scratch
+    std::vector<int> queue_of_;                   // plan() scratch
+    std::vector<uint32_t> fill_;                  // plan() scratch
+    std::atomic<uint64_t> steals_;
+    int active_;
+    uint64_t generation_;
+    bool stop_;
+};
+
+} // namespace superpy
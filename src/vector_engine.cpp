@@ -0,0 +1,312 @@
+/**
+ * SuperPy Vector Engine
+ *
+ * Owns N SuperPyEngine instances (each with its own private core) and steps
+ * them on a shared thread pool, writing every result into one contiguous
+ * set of buffers. step_async() hands the same batch to a background thread
+ * that drives the pool in place of the caller.
+ */
+
+#include "vector_engine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace superpy {
+
+// Weight of the newest sample in EnvCost::mean_us
+static constexpr float COST_SMOOTHING = 0.125f;
+
+static int pool_threads(int num_envs, int num_threads) {
+    if (num_threads <= 0) {
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    return std::max(1, std::min(num_threads, num_envs));
+}
+
+VectorEngine::VectorEngine(int num_envs, int num_threads, bool video)
+    : pool_(pool_threads(num_envs, num_threads)),
+      observation_bytes_(static_cast<size_t>(OBS_HEIGHT) * OBS_WIDTH * OBS_CHANNELS), feature_bytes_(0), front_(0),
+      cost_scheduling_(true), async_pending_(false), async_done_(false), async_stop_(false) {
+    if (num_envs <= 0) {
+        throw std::invalid_argument("num_envs must be positive");
+    }
+
+    engines_.reserve(num_envs);
+    for (int i = 0; i < num_envs; i++) {
+        engines_.push_back(std::make_unique<SuperPyEngine>(video));
+    }
+
+    allocate_results();
+    env_costs_.resize(num_envs);
+    schedule_costs_.assign(num_envs, 0.0f);
+}
+
+VectorEngine::~VectorEngine() {
+    if (!async_thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(async_mutex_);
+        async_stop_ = true;
+    }
+    async_cv_.notify_all();
+    // Finishes a pending batch first
+    async_thread_.join();
+}
+
+void VectorEngine::allocate_results() {
+    for (Results& results : results_) {
+        results.observations.assign(num_envs() * observation_bytes_, 0);
+        results.rewards.assign(num_envs(), 0.0f);
+        results.dones.reset(new bool[num_envs()]());
+        results.truncated.reset(new bool[num_envs()]());
+        results.features.assign(num_envs() * feature_bytes_, 0);
+    }
+}
+
+void VectorEngine::check_idle() const {
+    if (async_pending_) {
+        throw std::runtime_error("step_async() is pending; call step_wait() first");
+    }
+}
+
+void VectorEngine::check_pool(bool max_pool) const {
+    // Without a spec only the final frame is rendered, so there is nothing to pool
+    if (max_pool && !observation_) {
+        throw std::invalid_argument("max pooling needs an observation spec; call set_observation() first");
+    }
+}
+
+bool VectorEngine::load_rom(const std::string& path) {
+    check_idle();
+    std::atomic<bool> ok{true};
+    pool_.parallel_for(num_envs(), [&](int i) {
+        std::lock_guard<std::mutex> lock(engines_[i]->call_mutex());
+        if (!engines_[i]->load_rom(path)) ok = false;
+    });
+    return ok;
+}
+
+void VectorEngine::reset() {
+    check_idle();
+    Results& out = results_[front_ ^ 1];
+    pool_.parallel_for(num_envs(), [&](int i) {
+        std::lock_guard<std::mutex> lock(engines_[i]->call_mutex());
+        engines_[i]->reset();
+        write_results(out, i);
+    });
+    front_ ^= 1;
+}
+
+bool VectorEngine::add_reset_state() {
+    check_idle();
+    std::atomic<bool> ok{true};
+    pool_.parallel_for(num_envs(), [&](int i) {
+        std::lock_guard<std::mutex> lock(engines_[i]->call_mutex());
+        if (engines_[i]->add_reset_state() < 0) ok = false;
+    });
+    return ok;
+}
+
+void VectorEngine::step(const uint32_t* actions, int frames, bool max_pool) {
+    check_idle();
+    check_pool(max_pool);
+    run_step(actions, frames, max_pool);
+    front_ ^= 1;
+}
+
+void VectorEngine::run_step(const uint32_t* actions, int frames, bool max_pool) {
+    Results& out = results_[front_ ^ 1];
+    pool_.parallel_for(num_envs(), [&](int i) {
+        SuperPyEngine& engine = *engines_[i];
+        // Engines are also reachable from Python through VectorEngine[i]
+        std::lock_guard<std::mutex> lock(engine.call_mutex());
+        auto start = std::chrono::steady_clock::now();
+
+        if (observation_) {
+            engine.step_skip(actions[i], frames, max_pool, out.observations.data() + i * observation_bytes_);
+            write_status(out, i);
+        } else {
+            // Only the final frame is observed, so only it needs rendering.
+            // Every env runs all its frames, whatever its watches do.
+            engine.run_frames(actions[i], frames, true);
+            write_results(out, i);
+        }
+
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        record_cost(i, elapsed.count(), frames);
+    }, cost_scheduling_ ? schedule_costs_.data() : nullptr);
+}
+
+void VectorEngine::record_cost(int index, double elapsed_us, int frames) {
+    EnvCost& cost = env_costs_[index];
+    cost.last_us = static_cast<float>(elapsed_us / frames);
+    cost.mean_us = cost.steps == 0 ? cost.last_us : cost.mean_us + COST_SMOOTHING * (cost.last_us - cost.mean_us);
+    cost.total_us += elapsed_us;
+    cost.steps++;
+    schedule_costs_[index] = cost.mean_us;
+}
+
+void VectorEngine::set_cost_scheduling(bool enabled) {
+    check_idle();
+    cost_scheduling_ = enabled;
+}
+
+void VectorEngine::reset_env_costs() {
+    check_idle();
+    env_costs_.assign(num_envs(), EnvCost());
+    schedule_costs_.assign(num_envs(), 0.0f);
+}
+
+void VectorEngine::step_async(const uint32_t* actions, int frames, bool max_pool) {
+    check_idle();
+    check_pool(max_pool);
+    async_actions_.assign(actions, actions + num_envs());
+
+    if (!async_thread_.joinable()) {
+        async_thread_ = std::thread(&VectorEngine::async_loop, this);
+    }
+    {
+        std::lock_guard<std::mutex> lock(async_mutex_);
+        async_job_ = [this, frames, max_pool] { run_step(async_actions_.data(), frames, max_pool); };
+        async_done_ = false;
+        async_error_ = nullptr;
+    }
+    async_pending_ = true;
+    async_cv_.notify_all();
+}
+
+void VectorEngine::step_wait() {
+    if (!async_pending_) {
+        throw std::runtime_error("no step_async() is pending");
+    }
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(async_mutex_);
+        async_cv_.wait(lock, [this] { return async_done_; });
+        error = async_error_;
+    }
+    async_pending_ = false;
+    if (error) std::rethrow_exception(error);
+    // Only now: the accessors read front_ while the batch runs
+    front_ ^= 1;
+}
+
+void VectorEngine::async_loop() {
+    std::unique_lock<std::mutex> lock(async_mutex_);
+    for (;;) {
+        async_cv_.wait(lock, [this] { return async_stop_ || async_job_; });
+        if (!async_job_) return;
+
+        std::function<void()> job = std::move(async_job_);
+        async_job_ = nullptr;
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            job();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+
+        async_error_ = error;
+        async_done_ = true;
+        async_cv_.notify_all();
+    }
+}
+
+void VectorEngine::step_discrete(const int64_t* indices, int frames, bool max_pool) {
+    check_idle();
+    check_pool(max_pool);
+    action_masks_.resize(num_envs());
+    for (int i = 0; i < num_envs(); i++) {
+        if (indices[i] < 0 || static_cast<uint64_t>(indices[i]) >= action_table_.size()) {
+            throw std::out_of_range("action index " + std::to_string(indices[i]) + " out of range for action table of size " +
+                                    std::to_string(action_table_.size()));
+        }
+        action_masks_[i] = action_table_[indices[i]];
+    }
+    step(action_masks_.data(), frames, max_pool);
+}
+
+void VectorEngine::set_observation(const ObservationSpec& spec) {
+    check_idle();
+    // Validates the spec before touching any engine
+    observation_ = std::make_unique<ObservationPipeline>(spec);
+    observation_bytes_ = observation_->size_bytes();
+
+    for (auto& engine : engines_) {
+        std::lock_guard<std::mutex> lock(engine->call_mutex());
+        engine->set_observation(spec);
+    }
+    allocate_results();
+}
+
+void VectorEngine::set_features(std::shared_ptr<const RamFeatures> features) {
+    check_idle();
+    feature_bytes_ = features ? features->size_bytes() : 0;
+    for (auto& engine : engines_) {
+        std::lock_guard<std::mutex> lock(engine->call_mutex());
+        engine->set_features(features);
+    }
+    features_ = std::move(features);
+    allocate_results();
+}
+
+void VectorEngine::set_reward(const RewardProgram* program) {
+    check_idle();
+    for (auto& engine : engines_) {
+        std::lock_guard<std::mutex> lock(engine->call_mutex());
+        engine->set_reward(program ? std::make_unique<RewardProgram>(*program) : nullptr);
+    }
+}
+
+void VectorEngine::observation_shape(size_t out[3]) const {
+    if (observation_) {
+        observation_->shape(out);
+        return;
+    }
+    out[0] = OBS_HEIGHT;
+    out[1] = OBS_WIDTH;
+    out[2] = OBS_CHANNELS;
+}
+
+size_t VectorEngine::observation_element_size() const {
+    return observation_ ? observation_->element_size() : 1;
+}
+
+void VectorEngine::write_results(Results& out, int index) {
+    SuperPyEngine& engine = *engines_[index];
+    uint8_t* obs = out.observations.data() + index * observation_bytes_;
+
+    if (observation_) {
+        engine.observe(obs);
+    } else {
+        engine.copy_screen(reinterpret_cast<uint32_t*>(obs), OBS_WIDTH, OBS_HEIGHT);
+    }
+    write_status(out, index);
+}
+
+void VectorEngine::write_status(Results& out, int index) {
+    SuperPyEngine& engine = *engines_[index];
+    out.rewards[index] = engine.take_reward();
+    out.dones[index] = engine.is_done();
+    out.truncated[index] = engine.truncated();
+    if (features_) {
+        // The batch's own spec: engines may have been given another one
+        const uint8_t* ram = engine.get_memory();
+        uint8_t* dst = out.features.data() + index * feature_bytes_;
+        if (ram) {
+            features_->gather(ram, dst);
+        } else {
+            memset(dst, 0, feature_bytes_);
+        }
+    }
+}
+
+} // namespace superpy
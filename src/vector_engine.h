@@ -0,0 +1,171 @@
+/**
+ * SuperPy Vector Engine
+ * Batched stepping of many independent emulators
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+#include "snes9x_adapter.h"
+#include "thread_pool.h"
+
+namespace superpy {
+
+class VectorEngine {
+public:
+    // Default observation layout: (num_envs, OBS_HEIGHT, OBS_WIDTH, OBS_CHANNELS)
+    // RGBA, until set_observation() installs a native observation pipeline
+    static constexpr int OBS_HEIGHT = 224;
+    static constexpr int OBS_WIDTH = 256;
+    static constexpr int OBS_CHANNELS = 4;
+
+    // num_threads: 0 = one per hardware thread (capped at num_envs)
+    // video: false for no-video engines (see SuperPyEngine)
+    explicit VectorEngine(int num_envs, int num_threads = 0, bool video = true);
+    ~VectorEngine();
+
+    VectorEngine(const VectorEngine&) = delete;
+    VectorEngine& operator=(const VectorEngine&) = delete;
+
+    // Load the same ROM into every engine
+    bool load_rom(const std::string& path);
+    void reset();
+
+    // Record every engine's current state as a start state for reset()
+    // (see SuperPyEngine::add_reset_state)
+    bool add_reset_state();
+
+    // Advance every engine by `frames` frames holding actions[i] (raw joypad
+    // bitmasks, one per engine), in parallel. Only the observed frames are
+    // rendered: the last one, or the last two when max_pool is set (requires
+    // an observation spec, std::invalid_argument otherwise). Results land in
+    // observations()/rewards()/dones().
+    void step(const uint32_t* actions, int frames = 1, bool max_pool = false);
+
+    // Discrete actions: step() with actions[i] = table[indices[i]]. All
+    // indices are checked (std::out_of_range) before any engine runs.
+    void set_action_table(const std::vector<uint32_t>& masks) { action_table_ = masks; }
+    const std::vector<uint32_t>& action_table() const { return action_table_; }
+    void step_discrete(const int64_t* indices, int frames = 1, bool max_pool = false);
+
+    // Asynchronous step(): starts the batch on a background thread and
+    // returns at once, so the caller can work on the previous results
+    // meanwhile; step_wait() blocks until it is done and makes its results
+    // current. Results are double-buffered, so the buffers returned before
+    // step_async() stay untouched while it runs. Every other call except
+    // the accessors throws std::runtime_error while a step is pending, as
+    // does step_async() itself; step_wait() rethrows errors of the batch.
+    void step_async(const uint32_t* actions, int frames = 1, bool max_pool = false);
+    void step_wait();
+    bool step_pending() const { return async_pending_; }
+
+    // Produce observations through the engines' observation pipeline
+    void set_observation(const ObservationSpec& spec);
+
+    // RAM features gathered into features() after every step()/reset(),
+    // one row of features->size() values per engine; null clears them
+    void set_features(std::shared_ptr<const RamFeatures> features);
+    const std::shared_ptr<const RamFeatures>& features_spec() const { return features_; }
+
+    // Give every engine its own copy of a reward program (null clears it):
+    // rewards() then holds the reward of each engine's frames in the step,
+    // dones() its terminated or truncated flag and truncated() the latter
+    void set_reward(const RewardProgram* program);
+
+    // Per-engine observation shape (3 dims) and element size in bytes
+    void observation_shape(size_t out[3]) const;
+    size_t observation_element_size() const;
+
+    // Per-env step cost, measured around every engine's share of step()
+    // (microseconds per emulated frame). With cost scheduling on (the
+    // default), the scheduler deals envs to threads by their mean cost so
+    // expensive ROMs and scenes (SA-1, SuperFX) are spread out; stealing
+    // evens out the rest either way.
+    struct EnvCost {
+        float mean_us = 0.0f;   // exponential moving average
+        float last_us = 0.0f;
+        double total_us = 0.0;  // whole steps, all frames
+        uint64_t steps = 0;
+    };
+    const std::vector<EnvCost>& env_costs() const { return env_costs_; }
+    void reset_env_costs();
+    bool cost_scheduling() const { return cost_scheduling_; }
+    void set_cost_scheduling(bool enabled);
+    // Env steps run by a thread other than the one they were dealt to
+    uint64_t steals() const { return pool_.steals(); }
+
+    int num_envs() const { return static_cast<int>(engines_.size()); }
+    int num_threads() const { return pool_.size(); }
+    SuperPyEngine& engine(int index) { return *engines_[index]; }
+
+    // Contiguous result buffers of the latest step()/reset()/step_wait().
+    // Two sets alternate, so a set is overwritten by the call after next.
+    uint8_t* observations() { return results_[front_].observations.data(); }
+    float* rewards() { return results_[front_].rewards.data(); }
+    bool* dones() { return results_[front_].dones.get(); }
+    bool* truncated() { return results_[front_].truncated.get(); }
+    uint8_t* features() { return results_[front_].features.data(); }
+
+    // Held by the bindings around every call made without the GIL
+    std::mutex& call_mutex() { return call_mutex_; }
+
+private:
+    struct Results {
+        std::vector<uint8_t> observations;
+        std::vector<float> rewards;
+        std::unique_ptr<bool[]> dones;
+        std::unique_ptr<bool[]> truncated;
+        std::vector<uint8_t> features;
+    };
+
+    // Run one batch into the back buffer set; callers make it current
+    void run_step(const uint32_t* actions, int frames, bool max_pool);
+    void write_results(Results& out, int index);
+    void write_status(Results& out, int index);
+    void record_cost(int index, double elapsed_us, int frames);
+    void check_idle() const;
+    void check_pool(bool max_pool) const;
+    void allocate_results();
+    void async_loop();
+
+    std::mutex call_mutex_;
+    std::vector<std::unique_ptr<SuperPyEngine>> engines_;
+    ThreadPool pool_;
+
+    std::unique_ptr<ObservationPipeline> observation_;  // spec template, null = RGBA
+    size_t observation_bytes_;
+    std::shared_ptr<const RamFeatures> features_;
+    size_t feature_bytes_;
+    Results results_[2];
+    int front_;
+
+    std::vector<uint32_t> action_table_;
+    std::vector<uint32_t> action_masks_;  // step_discrete() scratch
+
+    std::vector<EnvCost> env_costs_;
+    std::vector<float> schedule_costs_;   // mean_us, as passed to the pool
+    bool cost_scheduling_;
+
+    // step_async(): batches run on async_thread_ (started on first use),
+    // which drives pool_ like a synchronous caller would
+    std::thread async_thread_;
+    std::mutex async_mutex_;
+    std::condition_variable async_cv_;
+    std::function<void()> async_job_;
+    std::vector<uint32_t> async_actions_;  // copy, the caller's may go away
+    std::exception_ptr async_error_;
+    bool async_pending_;
+    bool async_done_;
+    bool async_stop_;
+};
+
+} // namespace superpy
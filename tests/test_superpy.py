@@ -2,7 +2,7 @@
 SuperPy Test Suite
 
 These tests verify the library loads and exports the expected API.
-Full emulation tests require a ROM file.
+Emulation tests run the homebrew ROM generated by bench/test_rom.h.
 """
 
 import pytest
@@ -30,15 +30,17 @@ def test_screen_dimensions():
     assert SuperPy.SCREEN_HEIGHT == 224
 
 
-# ROM-dependent tests - skip if no ROM available
+# ROM-dependent tests run the homebrew ROM from bench/test_rom.h. Its WRAM:
+# $0000-$0001 main loop counter, $0002 frame counter (NMI), $0003 joypad
 @pytest.fixture
 def test_rom(tmp_path):
-    """Create a minimal test ROM (or skip if impossible)."""
-    # In real tests, you'd provide a path to a test ROM
-    pytest.skip("No test ROM available")
+    """Write the generated test ROM."""
+    from superpy._core import _write_test_rom
+    path = tmp_path / "test.sfc"
+    assert _write_test_rom(str(path))
+    return str(path)
 
 
-@pytest.mark.skip(reason="Requires ROM file")
 def test_load_rom(test_rom):
     """Test ROM loading."""
     from superpy import SuperPy
@@ -46,7 +48,6 @@ def test_load_rom(test_rom):
     assert snes.frame_count == 0
 
 
-@pytest.mark.skip(reason="Requires ROM file")  
 def test_step(test_rom):
     """Test frame stepping."""
     from superpy import SuperPy
@@ -56,7 +57,6 @@ def test_step(test_rom):
     assert snes.frame_count == 1
 
 
-@pytest.mark.skip(reason="Requires ROM file")
 def test_memory_access(test_rom):
     """Test RAM access."""
     from superpy import SuperPy
@@ -64,7 +64,6 @@ def test_memory_access(test_rom):
     assert len(snes.memory) == 131072  # 128KB
 
 
-@pytest.mark.skip(reason="Requires ROM file")
 def test_save_load_state(test_rom):
     """Test state save/load."""
     from superpy import SuperPy
@@ -83,6 +82,640 @@ def test_save_load_state(test_rom):
     for _ in range(60):
         snes.step({})
     
-    # Load state
+    # Load state; the episode's frame count starts over
     snes.load_state(state)
-    # Note: frame_count is Python-side, not saved in state
+    assert snes.frame_count == 0
+
+
+def test_multiple_engines_independent(test_rom):
+    """Test that engines in one process do not share emulator state."""
+    from superpy import SuperPy
+    a = SuperPy(test_rom)
+    b = SuperPy(test_rom)
+    
+    for _ in range(120):
+        a.step({"Start": True})
+    
+    # b has not run a single frame, so its RAM must not follow a
+    assert a.frame_count == 120
+    assert b.frame_count == 0
+    assert bytes(a.memory) != bytes(b.memory)
+
+
+def test_vector_engine_exported():
+    """Test that the batched engine is part of the public API."""
+    import superpy
+    assert "VectorEngine" in superpy.__all__
+    assert hasattr(superpy.VectorEngine, "step")
+
+
+def test_vector_engine_step(test_rom):
+    """Test batched stepping of several engines."""
+    import numpy as np
+    from superpy import VectorEngine
+    vec = VectorEngine(4, num_threads=2)
+    assert vec.load_rom(test_rom)
+    
+    obs, rewards, dones = vec.step(np.zeros(4, dtype=np.uint32), frames=4)
+    assert obs.shape == (4, 224, 256, 4)
+    assert rewards.shape == (4,)
+    assert dones.shape == (4,)
+    assert vec[0].frame_count == 4
+
+
+def test_vector_engine_max_pool_needs_spec():
+    """Test pool='max' is rejected without an observation spec."""
+    import numpy as np
+    from superpy import VectorEngine
+    vec = VectorEngine(2, num_threads=1)
+    actions = np.zeros(2, dtype=np.uint32)
+    with pytest.raises(ValueError):
+        vec.step(actions, frames=2, pool="max")
+    with pytest.raises(ValueError):
+        vec.step_async(actions, frames=2, pool="max")
+    assert not vec.step_pending
+
+
+def test_observation_shape():
+    """Test observation spec shapes without a ROM."""
+    from superpy._core import observation_shape
+    assert observation_shape() == (224, 256, 3)
+    assert observation_shape(size=(84, 84), color="gray") == (84, 84, 1)
+    assert observation_shape(size=(84, 84), layout="chw") == (3, 84, 84)
+    assert observation_shape(crop=(0, 16, 256, 192)) == (192, 256, 3)
+    
+    with pytest.raises(ValueError):
+        observation_shape(color="cmyk")
+    with pytest.raises(ValueError):
+        observation_shape(crop=(200, 0, 100, 10))
+
+
+def test_observe_into_buffer(test_rom):
+    """Test native observations written into a caller-owned buffer."""
+    import numpy as np
+    from superpy import SuperPy
+    snes = SuperPy(test_rom)
+    snes.set_observation(size=(84, 84), color="gray", interpolation="area")
+    snes.step({})
+    
+    out = np.empty((84, 84, 1), dtype=np.uint8)
+    assert snes.observe(out) is out
+
+
+def test_step_skip(test_rom):
+    """Test native frame skip with max pooling."""
+    from superpy import SuperPy
+    snes = SuperPy(test_rom)
+    snes.set_observation(size=(84, 84), color="gray")
+    
+    obs = snes.step_skip({"Right": True}, frames=4, pool="max")
+    assert obs.shape == (84, 84, 1)
+    assert snes.frame_count == 4
+
+
+def test_buttons_to_mask():
+    """Test that dict and MultiBinary inputs map to the same joypad mask."""
+    import numpy as np
+    from superpy import Engine, SuperPy
+    pressed = np.zeros(12, dtype=np.uint8)
+    pressed[SuperPy.BUTTONS.index("B")] = 1
+    pressed[SuperPy.BUTTONS.index("Right")] = 1
+    
+    mask = Engine.buttons_to_mask({"B": True, "Right": True})
+    assert mask != 0
+    assert Engine.buttons_to_mask(pressed) == mask
+    assert Engine.buttons_to_mask({}) == 0
+
+
+def test_action_table(test_rom):
+    """Test discrete actions resolved natively."""
+    from superpy import SuperPy
+    snes = SuperPy(test_rom)
+    snes.set_action_table([{}, {"Right": True}, [0] * 11 + [1]])
+    
+    snes.step(snes.action_mask(1))
+    with pytest.raises(IndexError):
+        snes.action_mask(3)
+    
+    snes.step_action(1)
+    assert snes.tick_action(2, 3, render=False) == 3
+    assert snes.frame_count == 5
+    with pytest.raises(IndexError):
+        snes.step_action(3)
+    assert snes.frame_count == 5
+
+
+def test_action_index_checked_without_rom():
+    """Test action indices are checked before any frame runs."""
+    from superpy import Engine
+    engine = Engine()
+    engine.set_action_table([0, 0x80])
+    with pytest.raises(IndexError):
+        engine.step_action(2)
+    with pytest.raises(IndexError):
+        engine.tick_action(-1, 4, render=False)
+    assert engine.tick_action(1, 4, render=False) == 0
+
+
+def test_save_state_into_buffer(test_rom):
+    """Test zero-copy save/load through caller-owned buffers."""
+    import numpy as np
+    from superpy import SuperPy
+    snes = SuperPy(test_rom)
+    snes.tick(60, render=False)
+    
+    buffer = np.empty(snes.state_size(), dtype=np.uint8)
+    assert snes.save_state_into(buffer) == snes.state_size()
+    assert bytes(buffer) == snes.save_state()
+    
+    snes.tick(60, render=False)
+    snes.load_state(buffer)
+    snes.load_state(memoryview(bytearray(buffer)))
+
+
+def test_state_pool(test_rom):
+    """Test handle-based snapshot slots."""
+    from superpy import SuperPy
+    snes = SuperPy(test_rom)
+    pool = snes.state_pool(4)
+    assert len(pool) == 4
+    assert pool.state_size == snes.state_size()
+    
+    assert pool.save(1)
+    assert not pool.restore(0)
+    ram = snes.memory.copy()
+    snes.tick(60, render=False)
+    assert pool.restore(1)
+    assert (snes.memory == ram).all()
+    
+    with pytest.raises(IndexError):
+        pool.save(4)
+
+
+def test_delta_archive(test_rom):
+    """Test delta snapshots reconstruct the exact saved state."""
+    from superpy import SuperPy
+    snes = SuperPy(test_rom)
+    archive = snes.delta_archive(keyframe_interval=4)
+    
+    ids, states = [], []
+    parent = None
+    for _ in range(10):
+        snes.tick(5, render=False)
+        parent = archive.save(parent)
+        ids.append(parent)
+        states.append(snes.save_state())
+    
+    assert archive.parent(ids[0]) is None
+    assert archive.memory_bytes < len(states) * archive.state_size
+    for snapshot, state in zip(reversed(ids), reversed(states)):
+        assert archive.restore(snapshot)
+        assert snes.save_state() == state
+
+
+def test_rewind(test_rom):
+    """Test the native rewind ring."""
+    from superpy import SuperPy
+    snes = SuperPy(test_rom)
+    snes.enable_rewind(depth=100, stride=2)
+    snes.tick(100, render=False)
+    
+    assert snes.rewind(10) == 10
+    assert snes.frame_count == 90
+    assert snes.rewind(1000) > 0
+    snes.reset()
+    assert snes.rewind(10) == 0
+
+
+def test_fast_reset(test_rom):
+    """Test resets restoring recorded start states."""
+    from superpy import SuperPy
+    snes = SuperPy(test_rom)
+    snes.tick(120, render=False)
+    assert snes.add_reset_state() == 0
+    
+    snes.tick(60, render=False)
+    snes.reset()
+    assert snes.frame_count == 0
+    snes.tick(10, render=False)
+    snes.reset(0)
+    assert snes.frame_count == 0
+    with pytest.raises(IndexError):
+        snes.reset(1)
+
+
+def test_shared_rom(test_rom):
+    """Test engines loading the same ROM share one image."""
+    from superpy import Engine
+    engines = [Engine() for _ in range(3)]
+    for engine in engines:
+        assert engine.load_rom(test_rom)
+        assert engine.rom_shared
+
+
+def test_fork_server(test_rom):
+    """Test stepping worker processes forked from a warmed-up engine."""
+    import numpy as np
+    from superpy import SuperPy
+    snes = SuperPy(test_rom)
+    snes.tick(60, render=False)
+    
+    with snes.fork(4) as workers:
+        assert len(workers) == 4
+        obs, rewards, dones = workers.step(np.zeros(4, dtype=np.uint32), frames=4)
+        assert obs.shape == (4, 224, 256, 3)
+        # Identical start states and inputs give identical frames
+        assert (obs == obs[0]).all()
+        obs, rewards, dones = workers.reset()
+    assert workers.closed
+    with pytest.raises(RuntimeError):
+        workers.step(np.zeros(4, dtype=np.uint32))
+
+
+def test_observation_ring_local():
+    """Test a ring round trip within one process."""
+    import os
+    from superpy import ObservationRing
+    name = f"superpy_test_{os.getpid()}"
+    ring = ObservationRing(name, num_envs=2, size=(84, 84), color="gray")
+    assert len(ring) == 2
+    assert ring.wait(timeout=0.01) is None
+    with pytest.raises(RuntimeError):
+        ring.release()
+    
+    worker = ObservationRing.attach(name)
+    assert worker.depth == 2
+
+
+def test_observation_ring_push_without_rom():
+    """Test pushing an engine without a ROM raises instead of crashing."""
+    import os
+    from superpy import Engine, ObservationRing
+    ring = ObservationRing(f"superpy_test_norom_{os.getpid()}", num_envs=1, size=(84, 84), color="gray",
+                           ram_addresses=[0x94])
+    engine = Engine()
+    engine.set_observation(size=(84, 84), color="gray")
+    with pytest.raises(RuntimeError):
+        ring.push(0, engine)
+
+
+def test_observation_ring_push(test_rom):
+    """Test pushing engine results into a ring."""
+    import os
+    from superpy import ObservationRing, SuperPy
+    ring = ObservationRing(f"superpy_test_{os.getpid()}", num_envs=1, ram_addresses=[0x02])
+    snes = SuperPy(test_rom)
+    snes.tick(10)
+    assert snes.push(ring, 0, reward=1.5)
+    obs, ram, rewards, dones = ring.wait()
+    assert obs.shape[0] == 1
+    assert ram[0, 0] == snes.memory[0x02]
+    assert rewards[0] == 1.5
+    ring.release()
+
+
+def test_vector_engine_step_async(test_rom):
+    """Test overlapping batches with step_async/step_wait."""
+    import numpy as np
+    from superpy import VectorEngine
+    vec = VectorEngine(4, num_threads=2)
+    assert vec.load_rom(test_rom)
+    actions = np.zeros(4, dtype=np.uint32)
+    
+    first, _, _ = vec.step(actions, frames=2)
+    snapshot = first.copy()
+    vec.step_async(actions, frames=2)
+    assert vec.step_pending
+    with pytest.raises(RuntimeError):
+        vec.step(actions)
+    # The previous results are not touched by the running batch
+    assert (first == snapshot).all()
+    obs, rewards, dones = vec.step_wait()
+    assert not vec.step_pending
+    assert not np.shares_memory(obs, first)
+    assert vec[0].frame_count == 4
+    with pytest.raises(RuntimeError):
+        vec.step_wait()
+
+
+def test_vector_engine_results_while_pending(test_rom):
+    """Test the current results stay those of the previous batch until step_wait()."""
+    import numpy as np
+    from superpy import VectorEngine
+    vec = VectorEngine(4, num_threads=2)
+    assert vec.load_rom(test_rom)
+    vec.set_reward(reward="1")
+    actions = np.zeros(4, dtype=np.uint32)
+    
+    first, first_rewards, _ = vec.step(actions)
+    vec.step_async(actions, frames=3)
+    for _ in range(100):
+        obs, rewards, dones = vec.results()
+        assert np.shares_memory(obs, first)
+        assert np.shares_memory(rewards, first_rewards)
+        assert (rewards == 1).all()
+    vec.step_wait()
+    obs, rewards, dones = vec.results()
+    assert not np.shares_memory(obs, first)
+    assert (rewards == 3).all()
+
+
+def test_vector_engine_env_costs(test_rom):
+    """Test per-env cost statistics of the batched scheduler."""
+    import numpy as np
+    from superpy import VectorEngine
+    vec = VectorEngine(4, num_threads=2)
+    assert vec.load_rom(test_rom)
+    for _ in range(3):
+        vec.step(np.zeros(4, dtype=np.uint32), frames=2)
+    
+    costs = vec.env_costs()
+    assert costs["steps"].tolist() == [3, 3, 3, 3]
+    assert (costs["mean_us"] > 0).all()
+    vec.reset_env_costs()
+    assert vec.env_costs()["steps"].sum() == 0
+    vec.cost_scheduling = False
+    assert not vec.cost_scheduling
+
+
+def test_frame_profiler(test_rom):
+    """Test per-subsystem frame profiling."""
+    from superpy import SuperPy
+    snes = SuperPy(test_rom)
+    assert not snes.profiling
+    snes.tick(10)
+    assert snes.profile_stats()["frames"] == 0
+    
+    snes.profiling = True
+    snes.tick(20)
+    snes.screen
+    stats = snes.profile_stats()
+    assert stats["frames"] == 20
+    for name in ("cpu", "ppu", "apu", "dma", "sa1", "superfx", "screen", "total"):
+        assert stats[name]["p50_us"] <= stats[name]["p99_us"]
+    assert stats["total"]["mean_us"] > stats["cpu"]["mean_us"] > 0
+    assert stats["screen"]["mean_us"] > 0
+    
+    snes._engine.reset_profile()
+    assert snes.profile_stats()["frames"] == 0
+
+
+def test_no_video(test_rom):
+    """Test no-video engines: emulation runs, nothing is rendered."""
+    import numpy as np
+    from superpy import SuperPy, VectorEngine
+    snes = SuperPy(test_rom, video=False)
+    assert not snes._engine.video
+    snes.tick(60)
+    assert snes.frame_count == 60
+    assert not snes.screen.any()
+    
+    reference = SuperPy(test_rom)
+    reference.tick(60)
+    assert np.array_equal(snes.memory, reference.memory)
+    
+    vec = VectorEngine(2, video=False)
+    assert vec.load_rom(test_rom)
+    obs, rewards, dones = vec.step(np.zeros(2, dtype=np.uint32), frames=2)
+    assert not obs.any()
+
+
+def test_ram_features_validation():
+    """Test RAM feature specs are checked when compiled, without a ROM."""
+    from superpy import Engine
+    engine = Engine()
+    engine.set_features([{"address": "0x0094", "type": "u16", "name": "player_x"}])
+    assert engine.features().shape == (1,)
+    
+    with pytest.raises(ValueError):
+        engine.set_features([{"address": 0x1FFFF, "type": "u16"}])
+    with pytest.raises(ValueError):
+        engine.set_features([{"address": 0x94, "type": "u32"}])
+    with pytest.raises(ValueError):
+        engine.set_features([{"address": 0x94, "type": "s16", "bcd": True}])
+    with pytest.raises(ValueError):
+        engine.set_features([{"address": 0x94, "scale": 0.5}], dtype="int32")
+    with pytest.raises(ValueError):
+        engine.set_features([{"adress": 0x94}])
+    
+    # Address strings: hex with 0x/$, decimal, nothing partial or octal-looking
+    engine.set_features([{"address": "$0094"}, {"address": "148"}, {"address": "0X94"}])
+    for bad in ["0094", "0x94zz", "$", "0x", "94 ", "-1"]:
+        with pytest.raises(ValueError, match="RAM address"):
+            engine.set_features([{"address": bad}])
+    
+    engine.set_features(None)
+    with pytest.raises(RuntimeError):
+        engine.features()
+
+
+def test_reward_program_validation():
+    """Test reward expressions are compiled and checked without a ROM."""
+    from superpy import Engine
+    engine = Engine()
+    engine.set_reward(
+        reward="delta(bcd24[0x0F34]) - 100 * decreased(u8[0x0DBE]) + clamp(s16be[0x10], -1, 1)",
+        terminated="u8[0xDBE] == 0 || (u8[0x19] & 0x03) != 0",
+        truncated="frame >= 18000",
+    )
+    assert engine.take_reward() == 0.0
+    assert not engine.done
+    
+    for bad in ["u8[0x94", "u32[0x94]", "u16[0x1FFFF]", "prev(delta(u8[1]))", "u8[u8[1]]", "1 +", "foo(1)"]:
+        with pytest.raises(ValueError):
+            engine.set_reward(reward=bad)
+    with pytest.raises(ValueError):
+        engine.set_reward(terminated="u8[1] ==")
+    
+    engine.set_reward()
+    assert not engine.terminated and not engine.truncated
+
+
+def test_reward_program(test_rom):
+    """Test rewards are summed over every frame and flags end the episode."""
+    import numpy as np
+    from superpy import SuperPy, VectorEngine
+    snes = SuperPy(test_rom)
+    snes.tick(60)
+    snes.set_reward(reward="1", truncated="frame >= 10")
+    snes.tick(4, render=False)
+    assert snes.take_reward() == 4.0
+    assert not snes.truncated
+    snes.tick(6, render=False)
+    assert snes.truncated and snes.done
+    
+    # Deltas start from the state restored, not the frame before it
+    state = snes.save_state()
+    snes.set_reward(reward="delta(u8[0x02])")
+    snes.tick(30)
+    snes.load_state(state)
+    assert snes.take_reward() == 0.0
+    assert not snes.done
+    
+    vec = VectorEngine(2)
+    assert vec.load_rom(test_rom)
+    vec.set_reward(reward="1", terminated="frame >= 3")
+    obs, rewards, dones = vec.step(np.zeros(2, dtype=np.uint32), frames=4)
+    assert list(rewards) == [4.0, 4.0]
+    assert dones.all() and not vec.truncated.any()
+
+
+def test_ram_watch_validation():
+    """Test RAM watches are checked when compiled, without a ROM."""
+    from superpy import Engine
+    engine = Engine()
+    engine.set_watches([
+        {"address": "0x0DBE"},
+        {"address": 0x94, "type": "u16", "kind": "rises", "value": 0x1000},
+        {"address": 0x100, "kind": "changed", "length": 16, "name": "sprites"},
+    ])
+    assert engine.watch_hit is None
+    
+    with pytest.raises(ValueError):
+        engine.set_watches([{"address": 0x94, "kind": "crosses", "value": 1}])
+    with pytest.raises(ValueError):
+        engine.set_watches([{"address": 0x94, "kind": "equals"}])
+    with pytest.raises(ValueError):
+        engine.set_watches([{"address": 0x1FFF0, "length": 32}])
+    with pytest.raises(ValueError):
+        engine.set_watches([{"address": 0x94, "lenght": 2}])
+    engine.set_watches(None)
+
+
+def test_ram_watch(test_rom):
+    """Test tick() stops on the frame a watch fires."""
+    from superpy import SuperPy
+    snes = SuperPy(test_rom)
+    snes.tick(60)
+    # The NMI counts frames at $0002
+    target = (int(snes.memory[0x02]) + 10) % 256
+    snes.set_watches([{"address": 0x02, "kind": "equals", "value": target}])
+    start = snes.frame_count
+    frames = snes.tick(600, render=False)
+    assert frames == 10
+    assert snes.watch_hit == (0, start + frames)
+    assert snes.frame_count == start + frames
+    # Each call reports its own hits
+    snes.step({})
+    assert snes.watch_hit is None
+    
+    snes.set_watches(None)
+    assert snes.tick(10, render=False) == 10
+    assert snes.watch_hit is None
+
+
+def test_vector_engine_step_runs_through_watches(test_rom):
+    """Test a watch on one env does not cut its batched step short."""
+    import numpy as np
+    from superpy import VectorEngine
+    vec = VectorEngine(2, num_threads=2)
+    assert vec.load_rom(test_rom)
+    vec[0].set_watches([{"address": 0x02, "kind": "changed"}])
+    actions = np.zeros(2, dtype=np.uint32)
+    
+    vec.step(actions, frames=4)
+    assert vec[0].frame_count == vec[1].frame_count == 4
+    assert vec[0].watch_hit == (0, 1)
+    
+    vec.set_observation(size=(84, 84), color="gray")
+    vec.step(actions, frames=4, pool="max")
+    assert vec[0].frame_count == vec[1].frame_count == 8
+    assert vec[0].watch_hit == (0, 5)
+
+
+def test_memory_trace_validation():
+    """Test memory trace ranges and capacity are checked without a ROM."""
+    from superpy import Engine
+    engine = Engine()
+    engine.trace_memory(0x0DBE, length=2, reads=True)
+    with pytest.raises(IndexError):
+        engine.trace_memory(0x1FFFF, length=2)
+    with pytest.raises(ValueError):
+        engine.trace_capacity = 0
+    engine.trace_capacity = 16
+    assert engine.trace_capacity == 16
+    engine.clear_trace()
+
+
+def test_ram_diff_without_rom():
+    """Test ram_diff() returns empty arrays without a ROM."""
+    import numpy as np
+    from superpy import Engine
+    engine = Engine()
+    engine.mark_ram()
+    indices, old, new = engine.ram_diff()
+    assert indices.dtype == np.uint32 and old.dtype == np.uint8 and new.dtype == np.uint8
+    assert len(indices) == len(old) == len(new) == 0
+
+
+def test_ram_diff(test_rom):
+    """Test RAM diffs against the memory view."""
+    import numpy as np
+    from superpy import SuperPy
+    snes = SuperPy(test_rom)
+    snes.tick(60)
+    snes.mark_ram()
+    before = snes.memory.copy()
+    snes.tick(10)
+    after = snes.memory.copy()
+    
+    indices, old, new = snes.ram_diff()
+    expected = np.flatnonzero(before != after)
+    assert np.array_equal(indices, expected)
+    assert np.array_equal(old, before[expected])
+    assert np.array_equal(new, after[expected])
+    
+    # Capped to the lowest addresses
+    if len(expected) > 1:
+        capped, _, _ = snes.ram_diff(max_changes=1)
+        assert list(capped) == [expected[0]]
+    
+    # advance makes the current RAM the reference
+    snes.ram_diff(advance=True)
+    assert len(snes.ram_diff()[0]) == 0
+
+
+def test_memory_trace(test_rom):
+    """Test traced WRAM writes match the memory they wrote."""
+    from superpy import SuperPy
+    snes = SuperPy(test_rom)
+    snes.tick(60)
+    # One 8-bit `inc $0002` per frame from the NMI handler
+    snes.trace_memory(0x02)
+    snes.tick(60, render=False)
+    events = snes.trace_events()
+    assert len(events["pc"]) == 60
+    assert (events["write"] == 1).all()
+    assert (events["address"] == 0x02).all() and (events["size"] == 1).all()
+    assert events["value"][-1] == snes.memory[0x02]
+    assert len(snes.trace_events()["pc"]) == 0
+    snes.clear_trace()
+
+
+def test_ram_features(test_rom):
+    """Test natively gathered RAM features against the memory view."""
+    import numpy as np
+    from superpy import SuperPy, VectorEngine
+    snes = SuperPy(test_rom)
+    snes.tick(120)
+    snes.set_features([
+        {"address": 0x00, "type": "u16"},
+        {"address": 0x00, "type": "u16", "endian": "big"},
+        {"address": 0x02, "mask": 0xF0, "shift": 4},
+        {"address": 0x02, "scale": 0.5},
+    ], dtype="float32")
+    mem = snes.memory
+    features = snes.features()
+    assert features.dtype == np.float32
+    assert features[0] == int.from_bytes(mem[0x00:0x02], "little")
+    assert features[1] == int.from_bytes(mem[0x00:0x02], "big")
+    assert features[2] == mem[0x02] >> 4
+    assert features[3] == mem[0x02] * 0.5
+    
+    vec = VectorEngine(2)
+    assert vec.load_rom(test_rom)
+    vec.set_features([{"address": 0x00, "type": "u16"}], dtype="int32")
+    vec.step(np.zeros(2, dtype=np.uint32), frames=2)
+    assert vec.features.shape == (2, 1)
+    assert vec.features.dtype == np.int32
+    assert vec.features[1, 0] == int.from_bytes(vec[1].memory[0x00:0x02], "little")